@@ -2,38 +2,145 @@
 
 #include "byte_stream.hh"
 #include "eventloop.hh"
+#include "exception.hh"
+#include "splice_pipe.hh"
 
 #include <iostream>
+#include <sys/stat.h>
 #include <unistd.h>
 
 using namespace std;
 
-void bidirectional_stream_copy( Socket& socket, string_view peer_name )
+namespace {
+constexpr size_t buffer_size = 1048576;
+constexpr size_t refill_threshold = 16384; // don't read into a ByteStream until it has at least this much room
+
+// splice(2) needs a pipe at one end of each call; the other end can be a pipe or a socket.
+bool can_splice( const FileDescriptor& fd )
 {
-  constexpr size_t buffer_size = 1048576;
+  struct stat st {};
+  CheckSystemCall( "fstat", ::fstat( fd.fd_num(), &st ) );
+  return S_ISFIFO( st.st_mode ) or S_ISSOCK( st.st_mode );
+}
 
+// Relay stdin -> socket and socket -> stdout entirely inside the kernel.
+// EOF and half-close behave the same as in the ByteStream relay below.
+void splice_relay( Socket& socket, FileDescriptor& input, FileDescriptor& output, string_view peer_name )
+{
   EventLoop eventloop {};
-  FileDescriptor input { STDIN_FILENO };
-  FileDescriptor output { STDOUT_FILENO };
-  ByteStream outbound { buffer_size };
-  ByteStream inbound { buffer_size };
+  SplicePipe outbound { buffer_size };
+  SplicePipe inbound { buffer_size };
   bool outbound_shutdown { false };
   bool inbound_shutdown { false };
+  bool error { false };
+
+  // rule 1: splice from stdin into outbound pipe
+  eventloop.add_rule(
+    "splice from stdin into outbound pipe",
+    input,
+    Direction::In,
+    [&] { outbound.fill_from( input ); },
+    [&] { return !error and outbound.wants_input(); },
+    [&] { outbound.set_source_done(); },
+    [&] {
+      cerr << "DEBUG: Outbound stream had error from source.\n";
+      error = true;
+    } );
+
+  // rule 2: splice from outbound pipe into socket
+  eventloop.add_rule(
+    "splice from outbound pipe into socket",
+    socket,
+    Direction::Out,
+    [&] {
+      outbound.drain_to( socket );
+      if ( outbound.source_done() and outbound.buffered() == 0 ) {
+        socket.shutdown( SHUT_WR );
+        outbound_shutdown = true;
+        cerr << "DEBUG: Outbound stream to " << peer_name << " finished.\n";
+      }
+    },
+    [&] {
+      return !error and ( outbound.buffered() or ( outbound.source_done() and not outbound_shutdown ) );
+    },
+    [&] { outbound.set_source_done(); },
+    [&] {
+      cerr << "DEBUG: Outbound stream had error from destination.\n";
+      error = true;
+    } );
+
+  // rule 3: splice from socket into inbound pipe
+  eventloop.add_rule(
+    "splice from socket into inbound pipe",
+    socket,
+    Direction::In,
+    [&] { inbound.fill_from( socket ); },
+    [&] { return !error and inbound.wants_input(); },
+    [&] { inbound.set_source_done(); },
+    [&] {
+      cerr << "DEBUG: Inbound stream had error from source.\n";
+      error = true;
+    } );
+
+  // rule 4: splice from inbound pipe into stdout
+  eventloop.add_rule(
+    "splice from inbound pipe into stdout",
+    output,
+    Direction::Out,
+    [&] {
+      inbound.drain_to( output );
+      if ( inbound.source_done() and inbound.buffered() == 0 ) {
+        output.close();
+        inbound_shutdown = true;
+        cerr << "DEBUG: Inbound stream from " << peer_name << " finished.\n";
+      }
+    },
+    [&] { return !error and ( inbound.buffered() or ( inbound.source_done() and not inbound_shutdown ) ); },
+    [&] { inbound.set_source_done(); },
+    [&] {
+      cerr << "DEBUG: Inbound stream had error from destination.\n";
+      error = true;
+    } );
+
+  // loop until completion
+  while ( true ) {
+    if ( EventLoop::Result::Exit == eventloop.wait_next_event( -1 ) ) {
+      return;
+    }
+  }
+}
+} // namespace
+
+void bidirectional_stream_copy( Socket& socket, string_view peer_name )
+{
+  FileDescriptor input { STDIN_FILENO };
+  FileDescriptor output { STDOUT_FILENO };
 
   socket.set_blocking( false );
   input.set_blocking( false );
   output.set_blocking( false );
 
+  // When stdin and stdout are pipes or sockets too, the bytes never need to visit userspace.
+  if ( can_splice( input ) and can_splice( output ) ) {
+    splice_relay( socket, input, output, peer_name );
+    return;
+  }
+
+  EventLoop eventloop {};
+  ByteStream outbound { buffer_size };
+  ByteStream inbound { buffer_size };
+  bool outbound_shutdown { false };
+  bool inbound_shutdown { false };
+
   // rule 1: read from stdin into outbound byte stream
-  eventloop.add_rule(
+  auto stdin_rule = eventloop.add_rule(
     "read from stdin into outbound byte stream",
     input,
     Direction::In,
     [&] {
-      string data;
-      data.resize( outbound.writer().available_capacity() );
-      input.read( data );
-      outbound.writer().push( move( data ) );
+      Writer& writer = outbound.writer();
+      const uint64_t len = min<uint64_t>( writer.available_capacity(), input.read_size_hint() );
+      writer.commit( input.read( writer.reserve( len ) ) );
       if ( input.eof() ) {
         outbound.writer().close();
       }
@@ -50,13 +157,13 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     } );
 
   // rule 2: read from outbound byte stream into socket
-  eventloop.add_rule(
+  auto socket_out_rule = eventloop.add_rule(
     "read from outbound byte stream into socket",
     socket,
     Direction::Out,
     [&] {
       if ( outbound.reader().bytes_buffered() ) {
-        outbound.reader().pop( socket.write( outbound.reader().peek() ) );
+        outbound.reader().pop( socket.write( outbound.reader().peek_all() ) );
       }
       if ( outbound.reader().is_finished() ) {
         socket.shutdown( SHUT_WR );
@@ -75,15 +182,14 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     } );
 
   // rule 3: read from socket into inbound byte stream
-  eventloop.add_rule(
+  auto socket_in_rule = eventloop.add_rule(
     "read from socket into inbound byte stream",
     socket,
     Direction::In,
     [&] {
-      string data;
-      data.resize( inbound.writer().available_capacity() );
-      socket.read( data );
-      inbound.writer().push( move( data ) );
+      Writer& writer = inbound.writer();
+      const uint64_t len = min<uint64_t>( writer.available_capacity(), socket.read_size_hint() );
+      writer.commit( socket.read( writer.reserve( len ) ) );
       if ( socket.eof() ) {
         inbound.writer().close();
       }
@@ -100,13 +206,13 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     } );
 
   // rule 4: read from inbound byte stream into stdout
-  eventloop.add_rule(
+  auto stdout_rule = eventloop.add_rule(
     "read from inbound byte stream into stdout",
     output,
     Direction::Out,
     [&] {
       if ( inbound.reader().bytes_buffered() ) {
-        inbound.reader().pop( output.write( inbound.reader().peek() ) );
+        inbound.reader().pop( output.write( inbound.reader().peek_all() ) );
       }
       if ( inbound.reader().is_finished() ) {
         output.close();
@@ -125,6 +231,14 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
       inbound.set_error();
     } );
 
+  // only consider each rule when its stream crosses a watermark, not on every iteration
+  outbound.set_writable_watermark( refill_threshold,
+                                   [stdin_rule]( bool x ) mutable { stdin_rule.set_active( x ); } );
+  outbound.set_readable_watermark( 1, [socket_out_rule]( bool x ) mutable { socket_out_rule.set_active( x ); } );
+  inbound.set_writable_watermark( refill_threshold,
+                                  [socket_in_rule]( bool x ) mutable { socket_in_rule.set_active( x ); } );
+  inbound.set_readable_watermark( 1, [stdout_rule]( bool x ) mutable { stdout_rule.set_active( x ); } );
+
   // loop until completion
   while ( true ) {
     if ( EventLoop::Result::Exit == eventloop.wait_next_event( -1 ) ) {
@@ -23,6 +23,14 @@ ttest(byte_stream_one_write)
 ttest(byte_stream_two_writes)
 ttest(byte_stream_many_writes)
 ttest(byte_stream_stress_test)
+ttest(byte_stream_peek_all)
+ttest(byte_stream_chunked)
+ttest(byte_stream_reserve)
+ttest(byte_stream_write_at)
+ttest(byte_stream_watermark)
+ttest(byte_stream_stats)
+ttest(buffer_pool)
+ttest(splice_pipe)
 
 ttest(reassembler_single)
 ttest(reassembler_cap)
@@ -31,6 +39,7 @@ ttest(reassembler_dup)
 ttest(reassembler_holes)
 ttest(reassembler_overlapping)
 ttest(reassembler_win)
+ttest(reassembler_random)
 
 ttest(wrapping_integers_cmp)
 ttest(wrapping_integers_wrap)
@@ -45,6 +54,8 @@ ttest(recv_reorder)
 ttest(recv_reorder_more)
 ttest(recv_close)
 ttest(recv_special)
+ttest(recv_coalesce)
+ttest(recv_sack)
 
 ttest(send_connect)
 ttest(send_transmit)
@@ -53,6 +64,12 @@ ttest(send_ack)
 ttest(send_close)
 ttest(send_retx)
 ttest(send_extra)
+ttest(send_rto)
+ttest(send_congestion)
+ttest(send_fast_retransmit)
+ttest(send_sack)
+ttest(send_pacing)
+ttest(send_nagle)
 
 ttest(net_interface)
 
@@ -93,4 +110,9 @@ set_property(TEST ${compile_name_opt} PROPERTY TIMEOUT 0)
 set_tests_properties(${compile_name_opt} PROPERTIES FIXTURES_SETUP compile_opt)
 
 stest(byte_stream_speed_test)
+stest(wrapping_integers_speed_test)
+stest(spsc_byte_stream_speed_test)
 stest(reassembler_speed_test)
+stest(reassembler_adversarial_speed_test)
+stest(sender_speed_test)
+stest(tcp_loss_speed_test)
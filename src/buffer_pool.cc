@@ -0,0 +1,131 @@
+#include "buffer_pool.hh"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <utility>
+
+using namespace std;
+
+BufferPool::BufferPool( uint64_t max_cached_bytes ) : max_cached_bytes_( max_cached_bytes ) {}
+
+// Never destroyed, so that streams with static storage duration can still return their buffers at exit.
+BufferPool& BufferPool::global()
+{
+  static auto* pool = new BufferPool {}; // NOLINT(*-owning-memory)
+  return *pool;
+}
+
+uint64_t BufferPool::class_size( uint64_t size )
+{
+  return size > max_class_size ? size : bit_ceil( max( size, min_class_size ) );
+}
+
+size_t BufferPool::class_index( uint64_t size )
+{
+  return countr_zero( class_size( size ) ) - countr_zero( min_class_size );
+}
+
+char* BufferPool::acquire( uint64_t size )
+{
+  const uint64_t rounded = class_size( size );
+  {
+    const lock_guard lock { mutex_ };
+    stats_.bytes_in_use += rounded;
+    stats_.peak_bytes_in_use = max( stats_.peak_bytes_in_use, stats_.bytes_in_use );
+    ++stats_.buffers_in_use;
+
+    if ( rounded <= max_class_size ) {
+      auto& free_list = free_lists_.at( class_index( size ) );
+      if ( not free_list.empty() ) {
+        char* data = free_list.back().release();
+        free_list.pop_back();
+        stats_.bytes_cached -= rounded;
+        ++stats_.reuses;
+        return data;
+      }
+    }
+    ++stats_.allocations;
+  }
+
+  // Allocate outside the lock; the contents are left uninitialized, as they would be when reused.
+  return make_unique_for_overwrite<char[]>( rounded ).release();
+}
+
+void BufferPool::release( char* data, uint64_t size )
+{
+  if ( data == nullptr ) {
+    return;
+  }
+
+  unique_ptr<char[]> buffer { data };
+  const uint64_t rounded = class_size( size );
+
+  const lock_guard lock { mutex_ };
+  stats_.bytes_in_use -= rounded;
+  --stats_.buffers_in_use;
+
+  if ( rounded <= max_class_size and stats_.bytes_cached + rounded <= max_cached_bytes_ ) {
+    free_lists_.at( class_index( size ) ).push_back( move( buffer ) );
+    stats_.bytes_cached += rounded;
+  }
+}
+
+BufferPool::Stats BufferPool::stats() const
+{
+  const lock_guard lock { mutex_ };
+  return stats_;
+}
+
+void BufferPool::reset_peak()
+{
+  const lock_guard lock { mutex_ };
+  stats_.peak_bytes_in_use = stats_.bytes_in_use;
+}
+
+void BufferPool::trim()
+{
+  const lock_guard lock { mutex_ };
+  for ( auto& free_list : free_lists_ ) {
+    free_list.clear();
+  }
+  stats_.bytes_cached = 0;
+}
+
+PooledBuffer::PooledBuffer( uint64_t size )
+  : data_( size ? BufferPool::global().acquire( size ) : nullptr ), size_( size )
+{}
+
+PooledBuffer::~PooledBuffer()
+{
+  BufferPool::global().release( data_, size_ );
+}
+
+PooledBuffer::PooledBuffer( const PooledBuffer& other ) : PooledBuffer( other.size_ )
+{
+  if ( size_ ) {
+    memcpy( data_, other.data_, size_ );
+  }
+}
+
+PooledBuffer& PooledBuffer::operator=( const PooledBuffer& other )
+{
+  if ( this != &other ) {
+    *this = PooledBuffer { other };
+  }
+  return *this;
+}
+
+PooledBuffer::PooledBuffer( PooledBuffer&& other ) noexcept
+  : data_( exchange( other.data_, nullptr ) ), size_( exchange( other.size_, 0 ) )
+{}
+
+PooledBuffer& PooledBuffer::operator=( PooledBuffer&& other ) noexcept
+{
+  if ( this != &other ) {
+    BufferPool::global().release( data_, size_ );
+    data_ = exchange( other.data_, nullptr );
+    size_ = exchange( other.size_, 0 );
+  }
+  return *this;
+}
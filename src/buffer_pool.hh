@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// A process-wide cache of byte buffers, shared by every ring-mode ByteStream (and so by a Reassembler writing
+// into one). Chunked streams, and a Reassembler feeding one, hold the caller's own strings instead.
+//
+// Requests are rounded up to a power-of-two size class. Released buffers go onto their class's free list
+// (up to a limit on the total bytes cached) and are handed out again to the next request of that class,
+// so connections that come and go, or streams that repeatedly go idle and wake up, reuse the same memory instead
+// of going back to the allocator. Requests larger than the biggest class bypass the cache.
+//
+// The pool is thread-safe (TCPMinnowSocket runs each connection's TCP machinery on its own thread).
+class BufferPool
+{
+public:
+  static constexpr uint64_t min_class_size = 64;
+  static constexpr uint64_t max_class_size = uint64_t { 1 } << 24;
+  static constexpr uint64_t default_max_cached_bytes = uint64_t { 64 } << 20;
+
+  struct Stats
+  {
+    uint64_t bytes_in_use {};      // held by callers (rounded up to the size class)
+    uint64_t peak_bytes_in_use {}; // high-water mark of bytes_in_use
+    uint64_t buffers_in_use {};    // number of buffers held by callers
+    uint64_t bytes_cached {};      // sitting on free lists, ready for reuse
+    uint64_t allocations {};       // requests that had to go to the allocator
+    uint64_t reuses {};            // requests satisfied from a free list
+  };
+
+  explicit BufferPool( uint64_t max_cached_bytes = default_max_cached_bytes );
+
+  // The pool shared by every ByteStream
+  static BufferPool& global();
+
+  char* acquire( uint64_t size );             // Get a buffer of at least `size` bytes
+  void release( char* data, uint64_t size );  // Return a buffer; `size` must match the acquire() call
+  Stats stats() const;                        // Snapshot of the pool's counters
+  void reset_peak();                          // Restart peak_bytes_in_use from the current bytes_in_use
+  void trim();                                // Free every cached buffer
+
+private:
+  static constexpr size_t num_classes = 19; // 64 B .. 16 MiB
+  static uint64_t class_size( uint64_t size );
+  static size_t class_index( uint64_t size );
+
+  uint64_t max_cached_bytes_;
+  mutable std::mutex mutex_ {};
+  std::array<std::vector<std::unique_ptr<char[]>>, num_classes> free_lists_ {};
+  Stats stats_ {};
+};
+
+// A fixed-size byte buffer drawn from the global BufferPool and returned to it on destruction.
+// Copying a PooledBuffer copies its contents into a new buffer of the same size.
+class PooledBuffer
+{
+public:
+  PooledBuffer() = default;
+  explicit PooledBuffer( uint64_t size );
+  ~PooledBuffer();
+
+  PooledBuffer( const PooledBuffer& other );
+  PooledBuffer& operator=( const PooledBuffer& other );
+  PooledBuffer( PooledBuffer&& other ) noexcept;
+  PooledBuffer& operator=( PooledBuffer&& other ) noexcept;
+
+  char* data() { return data_; }
+  const char* data() const { return data_; }
+  uint64_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+private:
+  char* data_ {};
+  uint64_t size_ {};
+};
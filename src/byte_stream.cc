@@ -1,82 +1,376 @@
 #include "byte_stream.hh"
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
 using namespace std;
 
-ByteStream::ByteStream( uint64_t capacity )
-  : capacity_( capacity )
-  , error_( false )
-  , isClosed( false )
-  , count_r( 0 )
-  , count_w( 0 )
-  , buffer( capacity + 1, '\0' )
+namespace {
+// Smallest ring worth drawing from the pool (unless the whole capacity is smaller)
+constexpr uint64_t min_ring_size = 4096;
+
+// Copy `data` into the ring `ring` (of power-of-two size) starting at stream index `index`,
+// in at most two pieces: up to the end of the ring, then the remainder at its start.
+void copy_into_ring( PooledBuffer& ring, uint64_t index, string_view data )
+{
+  const uint64_t start = index & ( ring.size() - 1 );
+  const uint64_t first = min<uint64_t>( data.size(), ring.size() - start );
+  memcpy( ring.data() + start, data.data(), first );
+  memcpy( ring.data(), data.data() + first, data.size() - first );
+}
+} // namespace
+
+// The ring's size is always a power of two, so that a stream index can be turned into a storage
+// offset with a mask instead of a division. No memory is taken until bytes are actually buffered.
+// A chunked stream never touches the ring and leaves it empty.
+ByteStream::ByteStream( uint64_t capacity, Storage storage )
+  : capacity_( capacity ), error_( false ), isClosed( false ), count_r( 0 ), count_w( 0 ), storage_( storage )
+{
+  if constexpr ( stats_enabled ) {
+    record_occupancy();
+  }
+}
+
+// Called after every change to the counters; only looks at the clock when the stream becomes, or stops being,
+// full or empty.
+void ByteStream::record_occupancy()
+{
+  const uint64_t buffered = count_w - count_r;
+  stats_.peak_buffered = max( stats_.peak_buffered, buffered );
+
+  const bool full = buffered == capacity_;
+  const bool empty = buffered == 0 and not isClosed;
+  if ( full == full_ and empty == empty_ ) {
+    return;
+  }
+
+  const auto now = chrono::steady_clock::now();
+  if ( full != full_ ) {
+    if ( full_ ) {
+      stats_.time_full += now - full_since_;
+    }
+    full_since_ = now;
+    full_ = full;
+  }
+  if ( empty != empty_ ) {
+    if ( empty_ ) {
+      stats_.time_empty += now - empty_since_;
+    }
+    empty_since_ = now;
+    empty_ = empty;
+  }
+}
+
+ByteStream::Stats ByteStream::stats() const
 {
-  buffer.clear(); // ַβ\0ַҪռ
+  Stats ret = stats_;
+  if ( full_ or empty_ ) {
+    const auto now = chrono::steady_clock::now();
+    if ( full_ ) {
+      ret.time_full += now - full_since_;
+    }
+    if ( empty_ ) {
+      ret.time_empty += now - empty_since_;
+    }
+  }
+  return ret;
+}
+
+// Grow by powers of two, never past the smallest power of two that holds the full capacity.
+void ByteStream::grow_ring( uint64_t needed )
+{
+  if ( needed <= buffer.size() ) {
+    return;
+  }
+
+  const uint64_t size = min( bit_ceil( max<uint64_t>( capacity_, 1 ) ), max( bit_ceil( needed ), min_ring_size ) );
+  PooledBuffer ring { size };
+  uint64_t index = count_r;
+  for ( const auto piece : reader().peek_all() ) {
+    copy_into_ring( ring, index, piece );
+    index += piece.size();
+  }
+  buffer = move( ring );
+  mask_ = buffer.size() - 1;
+}
+
+// Not while a reservation is outstanding (the caller may still be writing into the ring), nor while
+// bytes placed by write_at are waiting past the write cursor.
+void ByteStream::release_ring_if_drained()
+{
+  if ( count_r == count_w and reserved_ == 0 and staged_end_ <= count_w and not buffer.empty() ) {
+    buffer = {};
+    mask_ = 0;
+  }
+}
+
+void ByteStream::tick( uint64_t ms )
+{
+  if ( buffer.empty() ) {
+    return;
+  }
+  if ( count_r != count_w or count_w != idle_mark_ ) {
+    idle_mark_ = count_w;
+    idle_ms_ = 0;
+    return;
+  }
+  idle_ms_ += ms;
+  if ( idle_ms_ >= ring_idle_ms ) {
+    release_ring_if_drained();
+  }
 }
 
 void Writer::push( string data )
 {
-  // (void)data; // Your code here.
-  // Ƿ
-  uint64_t len = data.length();
-  uint64_t cap = available_capacity();
-  if ( cap < len ) {
-    buffer += data.substr( 0, cap );
-    count_w += cap;
-  } else {
-    buffer += data;
+  reserved_ = 0;
+
+  const uint64_t len = min<uint64_t>( data.size(), available_capacity() );
+  if ( len == 0 ) {
+    record_push( 0 );
+    return;
+  }
+
+  if ( storage_ == Storage::Chunked ) {
+    data.resize( len ); // truncating in place keeps the caller's allocation
+    chunks_.push_back( move( data ) );
     count_w += len;
+    record_push( len );
+    update_watermarks();
+    return;
+  }
+
+  grow_ring( count_w - count_r + len );
+  copy_into_ring( buffer, count_w, string_view { data }.substr( 0, len ) );
+  count_w += len;
+  record_push( len );
+  update_watermarks();
+}
+
+void ByteStream::set_error()
+{
+  error_ = true;
+  update_watermarks();
+}
+
+bool ByteStream::above_readable_mark() const
+{
+  return count_w - count_r >= readable_mark_.threshold or isClosed or error_;
+}
+
+bool ByteStream::above_writable_mark() const
+{
+  return capacity_ - ( count_w - count_r ) >= writable_mark_.threshold;
+}
+
+void ByteStream::set_readable_watermark( uint64_t low, WatermarkCallback callback )
+{
+  readable_mark_ = { low, move( callback ), false };
+  readable_mark_.state = above_readable_mark();
+  if ( readable_mark_.callback ) {
+    readable_mark_.callback( readable_mark_.state );
   }
 }
 
+void ByteStream::set_writable_watermark( uint64_t high, WatermarkCallback callback )
+{
+  writable_mark_ = { high, move( callback ), false };
+  writable_mark_.state = above_writable_mark();
+  if ( writable_mark_.callback ) {
+    writable_mark_.callback( writable_mark_.state );
+  }
+}
+
+void ByteStream::fire_watermarks()
+{
+  if ( readable_mark_.callback and above_readable_mark() != readable_mark_.state ) {
+    readable_mark_.state = not readable_mark_.state;
+    readable_mark_.callback( readable_mark_.state );
+  }
+
+  if ( writable_mark_.callback and above_writable_mark() != writable_mark_.state ) {
+    writable_mark_.state = not writable_mark_.state;
+    writable_mark_.callback( writable_mark_.state );
+  }
+}
+
+vector<span<char>> Writer::reserve( uint64_t len )
+{
+  reserved_ = min( len, available_capacity() );
+  if ( reserved_ == 0 ) {
+    return {};
+  }
+
+  if ( storage_ == Storage::Chunked ) {
+    reserved_chunk_.resize( reserved_ );
+    return { span<char> { reserved_chunk_ } };
+  }
+
+  grow_ring( count_w - count_r + reserved_ );
+  const uint64_t start = count_w & mask_;
+  const uint64_t first = min( reserved_, buffer.size() - start );
+  vector<span<char>> ret { { buffer.data() + start, first } };
+  if ( first < reserved_ ) {
+    ret.emplace_back( buffer.data(), reserved_ - first );
+  }
+  return ret;
+}
+
+void Writer::commit( uint64_t len )
+{
+  if ( len > reserved_ ) {
+    throw runtime_error( "Writer::commit() of more bytes than were reserved" );
+  }
+  reserved_ = 0;
+  if ( len == 0 ) {
+    record_push( 0 );
+    return;
+  }
+
+  if ( storage_ == Storage::Chunked ) {
+    reserved_chunk_.resize( len );
+    chunks_.push_back( move( reserved_chunk_ ) );
+    reserved_chunk_ = {};
+  }
+  count_w += len;
+  record_push( len );
+  update_watermarks();
+}
+
+// The first write_at takes a ring for the full capacity, so the ring never has to grow (and copy, or lose,
+// the staged bytes) while any are waiting.
+void Writer::write_at( uint64_t offset, string_view data )
+{
+  if ( storage_ != Storage::Ring ) {
+    throw runtime_error( "Writer::write_at() needs a stream with ring storage" );
+  }
+  if ( offset + data.size() > available_capacity() ) {
+    throw runtime_error( "Writer::write_at() beyond the available capacity" );
+  }
+  reserved_ = 0;
+  if ( data.empty() ) {
+    return;
+  }
+
+  grow_ring( capacity_ );
+  copy_into_ring( buffer, count_w + offset, data );
+  staged_end_ = max( staged_end_, count_w + offset + data.size() );
+}
+
+void Writer::advance( uint64_t len )
+{
+  if ( storage_ != Storage::Ring ) {
+    throw runtime_error( "Writer::advance() needs a stream with ring storage" );
+  }
+  if ( len > available_capacity() or count_w + len > max( staged_end_, count_w ) ) {
+    throw runtime_error( "Writer::advance() past the bytes placed by write_at()" );
+  }
+  reserved_ = 0;
+  if ( len == 0 ) {
+    record_push( 0 );
+    return;
+  }
+
+  count_w += len;
+  record_push( len );
+  update_watermarks();
+}
+
 void Writer::close()
 {
-  // Your code here.
   isClosed = true;
+  if constexpr ( stats_enabled ) {
+    record_occupancy();
+  }
+  update_watermarks();
 }
 
 bool Writer::is_closed() const
 {
-  return isClosed; // Your code here.
+  return isClosed;
 }
 
 uint64_t Writer::available_capacity() const
 {
-  return capacity_ - count_w + count_r; // Your code here.
+  return capacity_ - count_w + count_r;
 }
 
 uint64_t Writer::bytes_pushed() const
 {
-  return count_w; // Your code here.
+  return count_w;
 }
 
+// Returns the contiguous run of buffered bytes up to the point where the ring wraps,
+// or the unread remainder of the oldest chunk.
 string_view Reader::peek() const
 {
-  return string_view( buffer ); // Your code here.
+  if ( storage_ == Storage::Chunked ) {
+    return chunks_.empty() ? string_view {} : string_view { chunks_.front() }.substr( chunk_head_ );
+  }
+
+  const uint64_t start = count_r & mask_;
+  return { buffer.data() + start, min( bytes_buffered(), buffer.size() - start ) };
+}
+
+vector<string_view> Reader::peek_all() const
+{
+  vector<string_view> ret;
+  if ( storage_ == Storage::Chunked ) {
+    ret.reserve( chunks_.size() );
+    for ( const auto& chunk : chunks_ ) {
+      ret.emplace_back( chunk );
+    }
+    if ( not ret.empty() ) {
+      ret.front().remove_prefix( chunk_head_ );
+    }
+    return ret;
+  }
+
+  // At most two pieces: up to the wrap point, then from the start of the ring.
+  const string_view first = peek();
+  if ( not first.empty() ) {
+    ret.push_back( first );
+  }
+  if ( first.size() < bytes_buffered() ) {
+    ret.emplace_back( buffer.data(), bytes_buffered() - first.size() );
+  }
+  return ret;
 }
 
 void Reader::pop( uint64_t len )
 {
-  if ( count_w - count_r > len ) {
-    buffer.erase( 0, len );
-    count_r += len;
-  } else if ( count_w - count_r <= len ) {
-    buffer.clear();
-    count_r += count_w - count_r;
+  len = min( len, bytes_buffered() );
+  count_r += len;
+  record_pop( len );
+
+  if ( storage_ == Storage::Chunked ) {
+    while ( len > 0 ) {
+      const uint64_t remaining = chunks_.front().size() - chunk_head_;
+      if ( len < remaining ) {
+        chunk_head_ += len;
+        break;
+      }
+      len -= remaining;
+      chunks_.pop_front();
+      chunk_head_ = 0;
+    }
   }
-  // (void)len; // Your code here.
+
+  update_watermarks();
 }
 
 bool Reader::is_finished() const
 {
-  return isClosed && ( count_r == count_w ); // Your code here.
+  return isClosed && ( count_r == count_w );
 }
 
 uint64_t Reader::bytes_buffered() const
 {
-  return count_w - count_r; // Your code here.
+  return count_w - count_r;
 }
 
 uint64_t Reader::bytes_popped() const
 {
-  return count_r; // Your code here.
+  return count_r;
 }
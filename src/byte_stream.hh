@@ -1,8 +1,15 @@
 #pragma once
 
+#include "buffer_pool.hh"
+
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 class Reader;
 class Writer;
@@ -10,7 +17,18 @@ class Writer;
 class ByteStream
 {
 public:
-  explicit ByteStream( uint64_t capacity );
+  // How the buffered bytes are held:
+  //   Ring:    copied into a circular buffer drawn from the shared BufferPool only once there are bytes to hold,
+  //            grown (up to the capacity) as more are buffered, and returned to the pool once the stream has
+  //            sat drained for a while (see tick()).
+  //   Chunked: each pushed string is kept intact (moved, not copied) in a queue of chunks.
+  enum class Storage : uint8_t
+  {
+    Ring,
+    Chunked
+  };
+
+  explicit ByteStream( uint64_t capacity, Storage storage = Storage::Ring );
 
   // Helper functions (provided) to access the ByteStream's Reader and Writer interfaces
   Reader& reader();
@@ -18,8 +36,47 @@ public:
   Writer& writer();
   const Writer& writer() const;
 
-  void set_error() { error_ = true; };       // Signal that the stream suffered an error.
+  void set_error();                          // Signal that the stream suffered an error.
   bool has_error() const { return error_; }; // Has the stream had an error?
+  Storage storage() const { return storage_; } // How the buffered bytes are held
+
+  // Storage::Ring: a stream that drains keeps its ring, so that one that drains and refills all the time (a relay
+  // woken for every few packets) neither goes back to the pool nor regrows from the smallest size each time.
+  // tick( ms ) reports time passing; once the stream has sat drained and untouched for ring_idle_ms, the ring
+  // goes back to the pool.
+  static constexpr uint64_t ring_idle_ms = 100;
+  void tick( uint64_t ms );
+
+  // Watermark notifications, so that an event loop can react to changes instead of polling.
+  // Each callback is called once at registration with the current state, and afterwards only when it changes.
+  //   readable: bytes_buffered() >= `low`, or the stream is closed or has an error (the reader has work to do)
+  //   writable: available_capacity() >= `high` (worth refilling: avoids waking up for every byte popped)
+  using WatermarkCallback = std::function<void( bool )>;
+  void set_readable_watermark( uint64_t low, WatermarkCallback callback );
+  void set_writable_watermark( uint64_t high, WatermarkCallback callback );
+
+  // Occupancy and stall counters, to tell whether a slow transfer is held up by whoever reads the stream
+  // (time_full: the writer has no room) or by whoever fills it (time_empty: the reader has nothing to read).
+  // Kept in debug builds, and in optimized (NDEBUG) builds only if MINNOW_BYTE_STREAM_STATS is defined;
+  // otherwise they compile out and stats() reports zeros.
+#if !defined( NDEBUG ) || defined( MINNOW_BYTE_STREAM_STATS )
+  static constexpr bool stats_enabled = true;
+#else
+  static constexpr bool stats_enabled = false;
+#endif
+  struct Stats
+  {
+    uint64_t peak_buffered {};              // most bytes ever buffered at once
+    std::chrono::nanoseconds time_full {};  // time spent with no available capacity
+    std::chrono::nanoseconds time_empty {}; // time spent with nothing buffered while still open
+    uint64_t push_calls {};                 // push() and commit() calls
+    uint64_t pop_calls {};                  // pop() calls
+    uint64_t bytes_pushed {};               // bytes accepted by those push() and commit() calls
+    uint64_t bytes_popped {};               // bytes removed by those pop() calls
+    double average_push_size() const { return push_calls ? static_cast<double>( bytes_pushed ) / push_calls : 0; }
+    double average_pop_size() const { return pop_calls ? static_cast<double>( bytes_popped ) / pop_calls : 0; }
+  };
+  Stats stats() const; // Snapshot of the counters, including the time spent so far in a current full/empty spell
 
 protected:
   // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
@@ -28,7 +85,69 @@ protected:
   bool isClosed {};
   uint64_t count_r;
   uint64_t count_w;
-  std::string buffer;
+  Storage storage_;
+
+  // Storage::Ring
+  PooledBuffer buffer {}; // circular storage; its size is a power of two, empty while nothing is buffered
+  uint64_t mask_ {};      // buffer.size() - 1, maps a stream index to its offset in `buffer`
+  uint64_t idle_ms_ {};   // time the stream has sat drained, as reported to tick()
+  uint64_t idle_mark_ {}; // bytes_pushed() as of the last tick(), to tell whether the stream was used since
+
+  // Storage::Chunked
+  std::deque<std::string> chunks_ {}; // pushed strings, oldest first
+  uint64_t chunk_head_ {};            // bytes already popped from chunks_.front()
+  std::string reserved_chunk_ {};     // chunk handed out by Writer::reserve, not yet committed
+
+  uint64_t reserved_ {}; // bytes handed out by the last Writer::reserve
+  uint64_t staged_end_ {}; // Storage::Ring: stream index just past the furthest byte placed by Writer::write_at
+
+  struct Watermark
+  {
+    uint64_t threshold {};
+    WatermarkCallback callback {};
+    bool state {};
+  };
+  Watermark readable_mark_ {};
+  Watermark writable_mark_ {};
+
+  Stats stats_ {};
+  std::chrono::steady_clock::time_point full_since_ {};  // start of the current full spell, if full
+  std::chrono::steady_clock::time_point empty_since_ {}; // start of the current empty spell, if empty
+  bool full_ {};
+  bool empty_ {};
+
+  void record_push( uint64_t len )
+  {
+    if constexpr ( stats_enabled ) {
+      ++stats_.push_calls;
+      stats_.bytes_pushed += len;
+      record_occupancy();
+    }
+  }
+  void record_pop( uint64_t len )
+  {
+    if constexpr ( stats_enabled ) {
+      ++stats_.pop_calls;
+      stats_.bytes_popped += len;
+      record_occupancy();
+    }
+  }
+  void record_occupancy();
+
+  // Called after every change to the stream's state; cheap when no watermark is set
+  void update_watermarks()
+  {
+    if ( readable_mark_.callback or writable_mark_.callback ) {
+      fire_watermarks();
+    }
+  }
+  void fire_watermarks();
+  bool above_readable_mark() const;
+  bool above_writable_mark() const;
+
+  // Storage::Ring: make room for `needed` buffered bytes, and give the memory back once the stream is drained
+  void grow_ring( uint64_t needed );
+  void release_ring_if_drained();
 };
 
 class Writer : public ByteStream
@@ -40,14 +159,32 @@ public:
   bool is_closed() const;              // Has the stream been closed?
   uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
   uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
+
+  // Two-step alternative to push() that lets the caller (e.g. a read(2) or readv(2)) fill stream memory in place.
+  // reserve( n ) returns writable space for up to min( n, available_capacity() ) bytes, split into contiguous
+  // pieces; commit( n ) then appends the first n bytes written there. Any other write discards the reservation.
+  std::vector<std::span<char>> reserve( uint64_t len );
+  void commit( uint64_t len );
+
+  // Out-of-order writes into the free space (ring storage only), for a Reassembler that holds its pending bytes
+  // in the stream itself. write_at( offset, data ) places `data` at stream index bytes_pushed() + offset, which
+  // must lie within the available capacity, without making it readable; advance( n ) then appends the next n
+  // bytes, which must all have been placed by write_at (or already be in place). Bytes staged this way stay put
+  // through pushes, reservations and pops, except that a push, commit or advance over them replaces them.
+  void write_at( uint64_t offset, std::string_view data );
+  void advance( uint64_t len );
 };
 
 class Reader : public ByteStream
 {
 public:
-  std::string_view peek() const; // Peek at the next bytes in the buffer
+  std::string_view peek() const; // Peek at the next contiguous bytes (up to the ring's wrap point, or one chunk)
   void pop( uint64_t len );      // Remove `len` bytes from the buffer
 
+  // Peek at every buffered byte at once, as the sequence of contiguous pieces it is stored in
+  // (suitable for a single writev). Following up with pop( n ) removes the first n bytes of that sequence.
+  std::vector<std::string_view> peek_all() const;
+
   bool is_finished() const;        // Is the stream finished (closed and fully popped)?
   uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
   uint64_t bytes_popped() const;   // Total number of bytes cumulatively popped from stream
@@ -0,0 +1,221 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+unique_ptr<CongestionControl> CongestionControl::make( Algorithm algorithm, uint64_t mss )
+{
+  switch ( algorithm ) {
+    case Algorithm::NewReno:
+      return make_unique<NewReno>( mss );
+    case Algorithm::Cubic:
+      return make_unique<Cubic>( mss );
+    case Algorithm::BBRLite:
+      return make_unique<BBRLite>( mss );
+    case Algorithm::None:
+      break;
+  }
+  return nullptr;
+}
+
+namespace {
+// RFC 6928: min(10 * MSS, max(2 * MSS, 14600))
+uint64_t initial_window( uint64_t mss )
+{
+  return min( 10 * mss, max<uint64_t>( 2 * mss, 14600 ) );
+}
+} // namespace
+
+NewReno::NewReno( uint64_t mss ) : mss_( mss ), cwnd_( initial_window( mss ) ) {}
+
+void NewReno::on_ack( const Ack& ack )
+{
+  uint64_t acked = ack.bytes_acked;
+  if ( cwnd_ < ssthresh_ ) {
+    const uint64_t growth = min( acked, ssthresh_ - cwnd_ );
+    cwnd_ += growth;
+    acked -= growth;
+  }
+
+  // Congestion avoidance: one MSS per window's worth of bytes acknowledged
+  bytes_acked_ += acked;
+  while ( bytes_acked_ >= cwnd_ ) {
+    bytes_acked_ -= cwnd_;
+    cwnd_ += mss_;
+  }
+}
+
+void NewReno::on_timeout( uint64_t /* now_ms */, uint64_t bytes_in_flight )
+{
+  ssthresh_ = max( bytes_in_flight / 2, 2 * mss_ );
+  cwnd_ = mss_;
+  bytes_acked_ = 0;
+}
+
+void NewReno::on_fast_retransmit( uint64_t /* now_ms */, uint64_t bytes_in_flight )
+{
+  ssthresh_ = max( bytes_in_flight / 2, 2 * mss_ );
+  cwnd_ = ssthresh_;
+  bytes_acked_ = 0;
+}
+
+Cubic::Cubic( uint64_t mss )
+  : mss_( mss ), cwnd_( static_cast<double>( initial_window( mss ) ) / static_cast<double>( mss ) )
+{}
+
+uint64_t Cubic::cwnd() const
+{
+  return static_cast<uint64_t>( llround( cwnd_ * static_cast<double>( mss_ ) ) );
+}
+
+void Cubic::on_ack( const Ack& ack )
+{
+  if ( ack.rtt_ms.has_value() ) {
+    const auto rtt = static_cast<double>( *ack.rtt_ms );
+    srtt_ms_ = srtt_ms_ == 0 ? rtt : 0.875 * srtt_ms_ + 0.125 * rtt;
+  }
+
+  double segments_acked = static_cast<double>( ack.bytes_acked ) / static_cast<double>( mss_ );
+  if ( cwnd() < ssthresh_ ) {
+    const double ssthresh_segments = static_cast<double>( ssthresh_ ) / static_cast<double>( mss_ );
+    const double growth = min( segments_acked, ssthresh_segments - cwnd_ );
+    cwnd_ += growth;
+    segments_acked -= growth;
+    if ( segments_acked <= 0 ) {
+      return;
+    }
+  }
+
+  if ( not epoch_start_ms_.has_value() ) {
+    epoch_start_ms_ = ack.now_ms;
+    if ( cwnd_ < w_max_ ) {
+      k_s_ = cbrt( ( w_max_ - cwnd_ ) / C );
+      origin_ = w_max_;
+    } else {
+      k_s_ = 0;
+      origin_ = cwnd_;
+    }
+    w_est_ = cwnd_;
+  }
+
+  const auto w_cubic = [&]( double t_s ) { return C * pow( t_s - k_s_, 3 ) + origin_; };
+  const double t_s = static_cast<double>( ack.now_ms - *epoch_start_ms_ ) / 1000;
+
+  // The Reno-friendly estimate grows by alpha segments per window acknowledged
+  constexpr double alpha = 3 * ( 1 - beta ) / ( 1 + beta );
+  w_est_ += alpha * segments_acked / cwnd_;
+
+  if ( w_cubic( t_s ) < w_est_ ) {
+    cwnd_ = max( cwnd_, w_est_ );
+  } else {
+    // Aim for where the cubic will be one RTT from now, growing by at most half the window per RTT
+    const double target = clamp( w_cubic( t_s + srtt_ms_ / 1000 ), cwnd_, 1.5 * cwnd_ );
+    cwnd_ += ( target - cwnd_ ) / cwnd_ * segments_acked;
+  }
+}
+
+void Cubic::reduce()
+{
+  // Fast convergence: a flow that lost before regaining its previous maximum releases bandwidth sooner
+  w_max_ = cwnd_ < w_max_ ? cwnd_ * ( 1 + beta ) / 2 : cwnd_;
+  cwnd_ = max( cwnd_ * beta, 2.0 );
+  ssthresh_ = cwnd();
+  epoch_start_ms_.reset();
+}
+
+void Cubic::on_timeout( uint64_t /* now_ms */, uint64_t /* bytes_in_flight */ )
+{
+  reduce();
+  cwnd_ = 1;
+}
+
+void Cubic::on_fast_retransmit( uint64_t /* now_ms */, uint64_t /* bytes_in_flight */ )
+{
+  reduce();
+}
+
+BBRLite::BBRLite( uint64_t mss ) : mss_( mss ), cwnd_( initial_window( mss ) ) {}
+
+double BBRLite::bandwidth() const
+{
+  double ret = 0;
+  for ( const auto& [round, rate] : bandwidth_samples_ ) {
+    ret = max( ret, rate );
+  }
+  return ret;
+}
+
+uint64_t BBRLite::bdp() const
+{
+  // The sender's clock ticks in milliseconds, so an RTT below one still spans one
+  const uint64_t min_rtt = max<uint64_t>( min_rtt_ms_.value_or( 0 ), 1 );
+  return static_cast<uint64_t>( bandwidth() * static_cast<double>( min_rtt ) );
+}
+
+void BBRLite::on_ack( const Ack& ack )
+{
+  if ( ack.rtt_ms.has_value() ) {
+    const uint64_t rtt = *ack.rtt_ms;
+    const bool min_rtt_expired = ack.now_ms - min_rtt_stamp_ms_ > min_rtt_window_ms;
+    if ( not min_rtt_ms_.has_value() or rtt <= *min_rtt_ms_ or min_rtt_expired ) {
+      min_rtt_ms_ = rtt;
+      min_rtt_stamp_ms_ = ack.now_ms;
+    }
+
+    // A round trip ends when a segment sent after the previous one ended is acknowledged
+    bool round_start = false;
+    if ( ack.delivered_at_send >= next_round_delivered_ ) {
+      ++round_;
+      next_round_delivered_ = ack.delivered;
+      round_start = true;
+    }
+
+    // Delivery rate over the segment's flight
+    const auto interval = static_cast<double>( max<uint64_t>( rtt, 1 ) );
+    const double rate = static_cast<double>( ack.delivered - ack.delivered_at_send ) / interval;
+    if ( bandwidth_samples_.empty() or bandwidth_samples_.back().first != round_ ) {
+      bandwidth_samples_.emplace_back( round_, rate );
+    } else {
+      bandwidth_samples_.back().second = max( bandwidth_samples_.back().second, rate );
+    }
+    while ( bandwidth_samples_.front().first + bandwidth_window_rounds <= round_ ) {
+      bandwidth_samples_.pop_front();
+    }
+
+    if ( round_start and state_ == State::Startup ) {
+      if ( bandwidth() >= full_bandwidth_ * 1.25 ) {
+        full_bandwidth_ = bandwidth();
+        full_bandwidth_rounds_ = 0;
+      } else if ( ++full_bandwidth_rounds_ >= 3 ) {
+        state_ = State::Drain;
+      }
+    }
+  }
+
+  if ( state_ == State::Drain and ack.bytes_in_flight <= bdp() ) {
+    state_ = State::ProbeBandwidth;
+  }
+
+  if ( state_ == State::Startup or bandwidth() == 0 ) {
+    cwnd_ += ack.bytes_acked;
+    return;
+  }
+
+  // Drain holds the window at one BDP until the queue built up in startup is gone
+  const double gain = state_ == State::Drain ? 1 : cwnd_gain;
+  const uint64_t target = max( static_cast<uint64_t>( gain * static_cast<double>( bdp() ) ), 4 * mss_ );
+  cwnd_ = max( min( cwnd_ + ack.bytes_acked, target ), 4 * mss_ );
+}
+
+void BBRLite::on_timeout( uint64_t /* now_ms */, uint64_t /* bytes_in_flight */ )
+{
+  // Start again from one segment; ACKs grow the window straight back to the model's target
+  cwnd_ = mss_;
+}
+
+void BBRLite::on_fast_retransmit( uint64_t /* now_ms */, uint64_t /* bytes_in_flight */ )
+{
+  // The model, not loss, sizes the window
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+// The congestion window a TCPSender keeps in addition to the peer's receive window: the sender never has
+// more than min(receive window, cwnd()) sequence numbers outstanding. An algorithm grows the window as
+// ACKs arrive and shrinks it when the network signals loss.
+//
+// Windows are counted in sequence numbers (bytes); growth is driven by payload bytes acknowledged.
+class CongestionControl
+{
+public:
+  enum class Algorithm : uint8_t
+  {
+    None,    // no congestion window: send whatever the receive window allows
+    NewReno, // RFC 5681 slow start and congestion avoidance
+    Cubic,   // RFC 9438
+    BBRLite, // window sized from a model of bottleneck bandwidth and minimum RTT
+  };
+
+  // What the sender knows about an ACK that acknowledged new data
+  struct Ack
+  {
+    uint64_t now_ms {};                // sender's clock (total time passed to tick())
+    uint64_t bytes_acked {};           // payload bytes newly acknowledged
+    uint64_t bytes_in_flight {};       // sequence numbers still outstanding afterwards
+    uint64_t delivered {};             // payload bytes acknowledged so far, these included
+    std::optional<uint64_t> rtt_ms {}; // RTT of the newest segment acknowledged, unless it was retransmitted
+    uint64_t delivered_at_send {};     // `delivered` when that segment was sent (meaningful with rtt_ms)
+  };
+
+  // The algorithm's initial state, for segments of up to `mss` bytes (nullptr for Algorithm::None)
+  static std::unique_ptr<CongestionControl> make( Algorithm algorithm, uint64_t mss );
+
+  virtual ~CongestionControl() = default;
+
+  // Events: new data was acknowledged, the retransmission timer fired, or duplicate ACKs showed a loss (the
+  // sender then handles window inflation during fast recovery itself)
+  virtual void on_ack( const Ack& ack ) = 0;
+  virtual void on_timeout( uint64_t now_ms, uint64_t bytes_in_flight ) = 0;
+  virtual void on_fast_retransmit( uint64_t now_ms, uint64_t bytes_in_flight ) = 0;
+
+  virtual uint64_t cwnd() const = 0;         // Congestion window
+  virtual uint64_t ssthresh() const = 0;     // Slow-start threshold, or UINT64_MAX
+  virtual std::string_view name() const = 0; // For logs and benchmarks
+};
+
+// RFC 5681, with an RFC 6928 initial window. Slow start grows the window by every byte acknowledged (up to
+// ssthresh), so that stretch ACKs (e.g. after receive-side coalescing) don't slow it down.
+class NewReno : public CongestionControl
+{
+public:
+  explicit NewReno( uint64_t mss );
+
+  void on_ack( const Ack& ack ) override;
+  void on_timeout( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+  void on_fast_retransmit( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+  uint64_t cwnd() const override { return cwnd_; }
+  uint64_t ssthresh() const override { return ssthresh_; }
+  std::string_view name() const override { return "NewReno"; }
+
+private:
+  uint64_t mss_;
+  uint64_t cwnd_;
+  uint64_t ssthresh_ { UINT64_MAX };
+  uint64_t bytes_acked_ {}; // in congestion avoidance, acknowledged since cwnd last grew
+};
+
+// RFC 9438: after a loss the window follows a cubic function of the time since, centered on the window
+// where the loss happened, but never grows slower than Reno would.
+class Cubic : public CongestionControl
+{
+public:
+  static constexpr double C = 0.4;
+  static constexpr double beta = 0.7;
+
+  explicit Cubic( uint64_t mss );
+
+  void on_ack( const Ack& ack ) override;
+  void on_timeout( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+  void on_fast_retransmit( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+  uint64_t cwnd() const override;
+  uint64_t ssthresh() const override { return ssthresh_; }
+  std::string_view name() const override { return "CUBIC"; }
+
+private:
+  void reduce(); // multiplicative decrease, and the start of a new congestion-avoidance epoch
+
+  uint64_t mss_;
+  double cwnd_;                      // in segments
+  uint64_t ssthresh_ { UINT64_MAX }; // in bytes
+  double w_max_ {};                  // window (in segments) before the last reduction
+  std::optional<uint64_t> epoch_start_ms_ {};
+  double k_s_ {};    // seconds from the epoch's start until the window is back to w_max_
+  double origin_ {}; // window (in segments) at the plateau of the cubic
+  double w_est_ {};  // the window Reno would have (in segments)
+  double srtt_ms_ {};
+};
+
+// A BBR-style window without pacing: the congestion window is a multiple of the estimated bandwidth-delay
+// product, taking the bandwidth as the highest delivery rate of the last ten round trips and the delay as
+// the lowest RTT of the last ten seconds. Startup grows the window by every byte acknowledged until the
+// bandwidth estimate stops growing by 25% per round for three rounds. The window is then held at one BDP
+// while the queue built up in startup drains, and settles at twice the BDP. Only a timeout shrinks it.
+class BBRLite : public CongestionControl
+{
+public:
+  static constexpr double cwnd_gain = 2;
+  static constexpr uint64_t bandwidth_window_rounds = 10;
+  static constexpr uint64_t min_rtt_window_ms = 10000;
+
+  explicit BBRLite( uint64_t mss );
+
+  void on_ack( const Ack& ack ) override;
+  void on_timeout( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+  void on_fast_retransmit( uint64_t now_ms, uint64_t bytes_in_flight ) override;
+  uint64_t cwnd() const override { return cwnd_; }
+  uint64_t ssthresh() const override { return UINT64_MAX; }
+  std::string_view name() const override { return "BBR-lite"; }
+
+  double bandwidth() const; // bytes per millisecond (0 until the first sample)
+  uint64_t bdp() const;     // bandwidth-delay product, in bytes
+
+private:
+  enum class State : uint8_t
+  {
+    Startup,
+    Drain,
+    ProbeBandwidth,
+  };
+
+  uint64_t mss_;
+  uint64_t cwnd_;
+  State state_ { State::Startup };
+
+  uint64_t round_ {};
+  uint64_t next_round_delivered_ {};
+  std::deque<std::pair<uint64_t, double>> bandwidth_samples_ {}; // (round, best rate), one per round
+  std::optional<uint64_t> min_rtt_ms_ {};
+  uint64_t min_rtt_stamp_ms_ {};
+
+  double full_bandwidth_ {};
+  uint64_t full_bandwidth_rounds_ {}; // rounds without 25% growth
+};
@@ -1,173 +1,408 @@
 #include "reassembler.hh"
 
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
 #include "debug.hh"
 
 using namespace std;
 
-void Reassembler::insert(uint64_t first_index, string data, bool is_last_substring) {
-    // õfirst_unassembled_indexԼlast_unassembled_index ҿ
-    uint64_t first_unassembled_index = nextIndex;
-    uint64_t last_unassembled_index = first_unassembled_index + output_.writer().available_capacity();
-    // õһȽϺfirst_index
-    uint64_t new_first_index = first_index <= first_unassembled_index ? first_unassembled_index : first_index;
-    uint64_t new_last_index = first_index + data.length() >= last_unassembled_index
-                                  ? last_unassembled_index
-                                  : first_index + data.length();
-
-    setIsLastStr(is_last_substring, new_last_index, first_index + data.length());
-    if (is_last_substring && data.size() == 0 && map_.size() == 0) {
-        output_.writer().close();
+namespace {
+constexpr uint64_t word_bits = 64;
+
+// Mask of `count` bits starting at bit `offset` of a word (offset + count <= 64)
+uint64_t bit_range(uint64_t offset, uint64_t count) {
+    return (count == word_bits ? ~uint64_t{0} : (uint64_t{1} << count) - 1) << offset;
+}
+
+// Set the bits for positions [begin, end); returns how many of them were clear before.
+uint64_t setBits(vector<uint64_t>& bits, uint64_t begin, uint64_t end) {
+    uint64_t added = 0;
+    while (begin < end) {
+        const uint64_t offset = begin % word_bits;
+        const uint64_t count = min(word_bits - offset, end - begin);
+        const uint64_t mask = bit_range(offset, count);
+        uint64_t& word = bits[begin / word_bits];
+        added += popcount(mask & ~word);
+        word |= mask;
+        begin += count;
+    }
+    return added;
+}
+
+// Clear the bits for positions [begin, end); returns how many of them were set before.
+uint64_t clearBits(vector<uint64_t>& bits, uint64_t begin, uint64_t end) {
+    uint64_t removed = 0;
+    while (begin < end) {
+        const uint64_t offset = begin % word_bits;
+        const uint64_t count = min(word_bits - offset, end - begin);
+        const uint64_t mask = bit_range(offset, count);
+        uint64_t& word = bits[begin / word_bits];
+        removed += popcount(mask & word);
+        word &= ~mask;
+        begin += count;
+    }
+    return removed;
+}
+
+// Length of the run of set bits starting at position `begin`, looking no further than `end`.
+uint64_t countSetRun(const vector<uint64_t>& bits, uint64_t begin, uint64_t end) {
+    uint64_t position = begin;
+    while (position < end) {
+        const uint64_t offset = position % word_bits;
+        const uint64_t ones = countr_one(bits[position / word_bits] >> offset);
+        position += ones;
+        if (ones < word_bits - offset) {
+            break;
+        }
+    }
+    return min(position, end) - begin;
+}
+
+// Length of the run of set bits ending just before position `end`, looking no further back than `begin`.
+uint64_t countSetRunBefore(const vector<uint64_t>& bits, uint64_t begin, uint64_t end) {
+    uint64_t position = end;
+    while (position > begin) {
+        const uint64_t offset = (position - 1) % word_bits;
+        const uint64_t ones = countl_one(bits[(position - 1) / word_bits] << (word_bits - 1 - offset));
+        position -= ones;
+        if (ones < offset + 1) {
+            break;
+        }
+    }
+    return end - max(position, begin);
+}
+
+// Length of the run of clear bits starting at position `begin`, looking no further than `end`.
+uint64_t countClearRun(const vector<uint64_t>& bits, uint64_t begin, uint64_t end) {
+    uint64_t position = begin;
+    while (position < end) {
+        const uint64_t offset = position % word_bits;
+        const uint64_t zeros = min<uint64_t>(countr_zero(bits[position / word_bits] >> offset), word_bits - offset);
+        position += zeros;
+        if (zeros < word_bits - offset) {
+            break;
+        }
+    }
+    return min(position, end) - begin;
+}
+
+// Call f(ring_position, length) for the (at most two) pieces that the stream range
+// [first_index, first_index + length) occupies in a ring of `ring_size` positions.
+template <typename F>
+void forEachRingPiece(uint64_t ring_size, uint64_t first_index, uint64_t length, F&& f) {
+    const uint64_t start = first_index & (ring_size - 1);
+    const uint64_t first = min(length, ring_size - start);
+    f(start, first);
+    if (first < length) {
+        f(0, length - first);
+    }
+}
+}  // namespace
+
+void Reassembler::storeBitmap(uint64_t first_index, string_view data) {
+    if (present_.empty()) {
+        const uint64_t capacity = output_.writer().available_capacity() + output_.reader().bytes_buffered();
+        bitmapSize_ = bit_ceil(max<uint64_t>(capacity, 1));
+        present_.assign((bitmapSize_ + word_bits - 1) / word_bits, 0);
+    }
+
+    output_.writer().write_at(first_index - nextIndex, data);
+    forEachRingPiece(bitmapSize_, first_index, data.size(), [&](uint64_t position, uint64_t length) {
+        pending_ += setBits(present_, position, position + length);
+    });
+}
+
+void Reassembler::forgetBitmap(uint64_t first_index, uint64_t length) {
+    if (pending_ == 0) {
+        return;
     }
-    if (new_first_index >= new_last_index) {
+    forEachRingPiece(bitmapSize_, first_index, length, [&](uint64_t position, uint64_t count) {
+        pending_ -= clearBits(present_, position, position + count);
+    });
+}
+
+// Make the run of pending bytes (if any) that starts at the first unassembled index readable. The bytes
+// are already in place in the output, so this only moves its write cursor.
+void Reassembler::flushBitmap() {
+    if (pending_ == 0) {
         return;
     }
 
-    // õһindexڵnew_first_indexλ
-    auto it1 = map_.lower_bound(new_first_index);
-    if (it1 == map_.end()) {
-        // setIsLastStr(is_last_substring, new_last_index, first_index + data.length());
-        if (map_.size() != 0) {
-            --it1;
-            if (it1->first + it1->second.length() >= new_last_index) {
-                return;
-            }
-            if (it1->first + it1->second.length() > new_first_index) {
-                new_first_index = it1->first + it1->second.length();
-            }
+    const uint64_t start = nextIndex & (bitmapSize_ - 1);
+    uint64_t run = countSetRun(present_, start, bitmapSize_);
+    if (start + run == bitmapSize_) {
+        run += countSetRun(present_, 0, start);
+    }
+
+    if (run > 0) {
+        output_.writer().advance(run);
+        forgetBitmap(nextIndex, run);
+        nextIndex += run;
+    }
+
+    // Give the bitmap back once nothing is pending.
+    if (pending_ == 0) {
+        present_ = {};
+    }
+}
+
+// The bytes a slice refers to, as a string of their own.
+std::string Reassembler::takeSlice(Slice& slice) {
+    if (slice.payload.use_count() > 1) {
+        return slice.payload->substr(slice.offset, slice.length);
+    }
+    // Sole owner: reuse the payload's own allocation.
+    string bytes = std::move(*slice.payload);
+    bytes.resize(slice.offset + slice.length);
+    bytes.erase(0, slice.offset);
+    return bytes;
+}
+
+// Keep the parts of [begin, end) of `data` (which starts at `first_index`) that no slice holds yet.
+void Reassembler::storeSlices(uint64_t first_index, uint64_t begin, uint64_t end, string data) {
+    auto payload = make_shared<string>(std::move(data));
+    auto it = slices_.upper_bound(begin);
+    if (it != slices_.begin()) {
+        const auto& [index, slice] = *prev(it);
+        begin = max(begin, index + slice.length);
+    }
+
+    while (begin < end) {
+        const uint64_t gap_end = it == slices_.end() ? end : min(end, it->first);
+        if (begin < gap_end) {
+            slices_.emplace_hint(it, begin, Slice{payload, begin - first_index, gap_end - begin});
+            pending_ += gap_end - begin;
         }
-        if (new_first_index == nextIndex) {
-            output_.writer().push(
-                data.substr(new_first_index - first_index, new_last_index - new_first_index));
-            nextIndex = new_last_index;
-            if (isGetLastString && map_.size() == 0) {
-                output_.writer().close();
-            }
-            return;
+        if (it == slices_.end()) {
+            break;
+        }
+        begin = max(begin, it->first + it->second.length);
+        ++it;
+    }
+}
+
+// Drop everything held below `end`, narrowing a slice that straddles it.
+void Reassembler::forgetSlices(uint64_t end) {
+    auto it = slices_.begin();
+    while (it != slices_.end() && it->first < end) {
+        const uint64_t slice_end = it->first + it->second.length;
+        if (slice_end <= end) {
+            pending_ -= it->second.length;
+            it = slices_.erase(it);
+            continue;
+        }
+        const uint64_t overlap = end - it->first;
+        auto node = slices_.extract(it);
+        node.key() = end;
+        node.mapped().offset += overlap;
+        node.mapped().length -= overlap;
+        pending_ -= overlap;
+        slices_.insert(std::move(node));
+        break;
+    }
+}
+
+// Push the slices (if any) that continue from the first unassembled index.
+void Reassembler::flushSlices() {
+    while (!slices_.empty() && slices_.begin()->first == nextIndex) {
+        Slice& slice = slices_.begin()->second;
+        pending_ -= slice.length;
+        nextIndex += slice.length;
+        output_.writer().push(takeSlice(slice));
+        slices_.erase(slices_.begin());
+    }
+}
+
+void Reassembler::insert(uint64_t first_index, string data, bool is_last_substring) {
+    Segment segment{first_index, std::move(data), is_last_substring};
+    insert_batch(span<Segment>(&segment, 1));
+}
+
+void Reassembler::insert_batch(span<Segment> segments) {
+    if (segments.size() > 1) {
+        ranges::stable_sort(segments, {}, &Segment::first_index);
+    }
+
+    // Only bytes in [first unassembled, first unacceptable) are kept.
+    const uint64_t first_unassembled = nextIndex;
+    const uint64_t first_unacceptable = first_unassembled + output_.writer().available_capacity();
+
+    // The in-order run: each segment that starts within what is contiguous so far, trimmed in place
+    // to the bytes it adds.
+    uint64_t run_end = first_unassembled;
+    size_t i = 0;
+    for (; i < segments.size() && segments[i].first_index <= run_end; ++i) {
+        Segment& segment = segments[i];
+        if (segment.is_last_substring) {
+            endIndex_ = segment.first_index + segment.data.size();
+        }
+        const uint64_t end = min(segment.first_index + segment.data.size(), first_unacceptable);
+        if (end > run_end) {
+            segment.data.resize(end - segment.first_index);
+            segment.data.erase(0, run_end - segment.first_index);
+            run_end = end;
         } else {
-            map_.insert(make_pair(new_first_index, data.substr(new_first_index - first_index,
-                                                               new_last_index - new_first_index)));
-            return;
-        }
-    }
-    ////ڵõһСϽ
-    auto it2 = map_.upper_bound(new_first_index);
-    auto lit1 = map_.lower_bound(new_last_index);
-
-    if (it1 == map_.begin() && it2 == it1) {
-        if (new_first_index == nextIndex) {
-            // setIsLastStr(is_last_substring, new_last_index, first_index + data.length());
-            while (it2 != lit1) {
-                if (it2->first + it2->second.length() < new_last_index) {
-                    auto temp = it2;
-                    ++it2;
-                    map_.erase(temp);
-                } else {
-                    new_last_index = it2->first;
-                    break;
-                }
-            }
-            output_.writer().push(
-                data.substr(new_first_index - first_index, new_last_index - new_first_index));
-            nextIndex = new_last_index;
-            while (it2 != map_.end() && it2->first == nextIndex) {
-                output_.writer().push(it2->second);
-                nextIndex = it2->first + it2->second.length();
-                auto temp = it2;
-                ++it2;
-                map_.erase(temp);
-            }
-            if (isGetLastString && map_.size() == 0) {
-                output_.writer().close();
-            }
-            return;
+            segment.data.clear();
+        }
+    }
+    if (run_end > first_unassembled) {
+        // Straight to the output, superseding any copy of these bytes already pending.
+        if (useBitmap_) {
+            forgetBitmap(first_unassembled, run_end - first_unassembled);
         } else {
-            while (it2 != lit1) {
-                if (it2->first + it2->second.length() < new_last_index) {
-                    auto temp = it2;
-                    ++it2;
-                    map_.erase(temp);
-                } else {
-                    new_last_index = it2->first;
-                    break;
-                }
-            }
-            // setIsLastStr(is_last_substring, new_last_index, first_index + data.length());
-            map_.insert(make_pair(new_first_index, data.substr(new_first_index - first_index,
-                                                               new_last_index - new_first_index)));
-            return;
-        }
-
-        // if (new_first_index == nextIndex) {
-        //     output_.writer().push(
-        //         data.substr(new_first_index - first_index, new_last_index - new_first_index));
-        //     nextIndex = new_last_index;
-        //     while (it1 != map_.end() && it1->first == nextIndex) {
-        //         output_.writer().push(it1->second);
-        //         nextIndex = it1->first + it1->second.length();
-        //         auto temp = it1;
-        //         ++it1;
-        //         map_.erase(temp);
-        //     }
-        //     if (isGetLastString && map_.size() == 0) {
-        //         output_.writer().close();
-        //     }
-        //     return;
-        // } else {
-        //     map_.insert(make_pair(new_first_index, data.substr(new_first_index - first_index,
-        //                                                        new_last_index - new_first_index)));
-        //     return;
-        // }
-    }
-
-    if (it1 != it2) {
-        if (it1->first + it1->second.length() >= new_last_index) {
-            return;
+            forgetSlices(run_end);
+        }
+        pushRun(segments.first(i), run_end - first_unassembled);
+        nextIndex = run_end;
+    }
+
+    // The rest is out of order: hold on to it.
+    for (; i < segments.size(); ++i) {
+        Segment& segment = segments[i];
+        if (segment.is_last_substring) {
+            endIndex_ = segment.first_index + segment.data.size();
+        }
+        const uint64_t begin = max(segment.first_index, nextIndex);
+        const uint64_t end = min(segment.first_index + segment.data.size(), first_unacceptable);
+        if (begin >= end) {
+            continue;
+        }
+        if (useBitmap_) {
+            storeBitmap(begin, string_view(segment.data).substr(begin - segment.first_index, end - begin));
         } else {
-            while (it1 != lit1) {
-                if (it1->first + it1->second.length() < new_last_index) {
-                    auto temp = it1;
-                    ++it1;
-                    map_.erase(temp);
-                } else {
-                    new_last_index = it1->first;
-                    break;
-                }
-            }
-            // setIsLastStr(is_last_substring, new_last_index, first_index + data.length());
-            map_.insert(make_pair(new_first_index, data.substr(new_first_index - first_index,
-                                                               new_last_index - new_first_index)));
+            storeSlices(segment.first_index, begin, end, std::move(segment.data));
         }
+    }
+
+    if (useBitmap_) {
+        flushBitmap();
     } else {
-        --it1;
-        if (it1->first + it1->second.length() >= new_last_index) {
-            return;
-        }
-        if (it1->first + it1->second.length() > new_first_index) {
-            new_first_index = it1->first + it1->second.length();
-        }
-
-        while (it2 != lit1) {
-            if (it2->first + it2->second.length() < new_last_index) {
-                auto temp = it2;
-                ++it2;
-                map_.erase(temp);
-            } else {
-                new_last_index = it2->first;
-                break;
+        flushSlices();
+    }
+    if (endIndex_.has_value() && nextIndex == *endIndex_) {
+        output_.writer().close();
+    }
+}
+
+// Push the (already trimmed, consecutive) data of `run`, `length` bytes in all. A chunked output takes
+// each piece by move; a ring gets them all copied into one reservation.
+void Reassembler::pushRun(span<Segment> run, uint64_t length) {
+    if (!useBitmap_ || run.size() == 1) {
+        for (Segment& segment : run) {
+            if (!segment.data.empty()) {
+                output_.writer().push(std::move(segment.data));
+            }
+        }
+        return;
+    }
+
+    const auto spans = output_.writer().reserve(length);
+    auto destination = spans.begin();
+    uint64_t filled = 0;
+    for (const Segment& segment : run) {
+        string_view piece = segment.data;
+        while (!piece.empty()) {
+            const uint64_t n = min<uint64_t>(piece.size(), destination->size() - filled);
+            memcpy(destination->data() + filled, piece.data(), n);
+            piece.remove_prefix(n);
+            filled += n;
+            if (filled == destination->size()) {
+                ++destination;
+                filled = 0;
             }
         }
-        // setIsLastStr(is_last_substring, new_last_index, first_index + data.length());
-        map_.insert(make_pair(new_first_index,
-                              data.substr(new_first_index - first_index, new_last_index - new_first_index)));
     }
+    output_.writer().commit(length);
 }
 
 // How many bytes are stored in the Reassembler itself?
-// This function is for testing only; don't add extra state to support it.
-uint64_t Reassembler::count_bytes_pending() const {
-    uint64_t sum = 0;
-    for (auto it = map_.begin(); it != map_.end(); ++it) {
-        sum += it->second.length();
+uint64_t Reassembler::count_bytes_pending() const { return pending_; }
+
+vector<Reassembler::Range> Reassembler::received_ranges(size_t max_ranges) const {
+    vector<Range> ranges;
+    if (useBitmap_) {
+        // Alternate runs of clear and set bits, a word at a time, until every pending byte is accounted for.
+        const uint64_t mask = bitmapSize_ - 1;
+        const auto run = [&](auto count, uint64_t index) {
+            const uint64_t position = index & mask;
+            uint64_t length = count(present_, position, bitmapSize_);
+            if (position + length == bitmapSize_) {
+                length += count(present_, 0, position);
+            }
+            return length;
+        };
+        uint64_t index = nextIndex;
+        uint64_t found = 0;
+        while (found < pending_ && ranges.size() < max_ranges) {
+            index += run(countClearRun, index);
+            const uint64_t length = run(countSetRun, index);
+            ranges.push_back({index, length});
+            index += length;
+            found += length;
+        }
+        return ranges;
+    }
+
+    // Adjacent slices (e.g. pieces of one payload around a slice already held) make up a single range.
+    for (const auto& [index, slice] : slices_) {
+        if (!ranges.empty() && ranges.back().first_index + ranges.back().length == index) {
+            ranges.back().length += slice.length;
+        } else if (ranges.size() < max_ranges) {
+            ranges.push_back({index, slice.length});
+        } else {
+            break;
+        }
+    }
+    return ranges;
+}
+
+optional<Reassembler::Range> Reassembler::received_range_at(uint64_t index) const {
+    if (index < nextIndex || pending_ == 0) {
+        return nullopt;
+    }
+    if (useBitmap_) {
+        if (index - nextIndex >= bitmapSize_) {
+            return nullopt;
+        }
+        // The run can't wrap all the way round: the bit for nextIndex is always clear.
+        const uint64_t position = index & (bitmapSize_ - 1);
+        uint64_t after = countSetRun(present_, position, bitmapSize_);
+        if (after == 0) {
+            return nullopt;
+        }
+        if (position + after == bitmapSize_) {
+            after += countSetRun(present_, 0, position);
+        }
+        uint64_t before = countSetRunBefore(present_, 0, position);
+        if (before == position) {
+            before += countSetRunBefore(present_, position, bitmapSize_);
+        }
+        return Range{index - before, before + after};
+    }
+
+    auto it = slices_.upper_bound(index);
+    if (it == slices_.begin()) {
+        return nullopt;
+    }
+    --it;
+    if (index >= it->first + it->second.length) {
+        return nullopt;
+    }
+    // Widen over the adjacent slices on either side, as received_ranges() does.
+    Range range{it->first, it->second.length};
+    for (auto prev = it; prev != slices_.begin();) {
+        --prev;
+        if (prev->first + prev->second.length != range.first_index) {
+            break;
+        }
+        range.first_index = prev->first;
+        range.length += prev->second.length;
+    }
+    for (auto next = std::next(it); next != slices_.end() && next->first == range.first_index + range.length;
+         ++next) {
+        range.length += next->second.length;
     }
-    return sum;
+    return range;
 }
@@ -1,12 +1,19 @@
 #pragma once
 
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
 #include "byte_stream.hh"
 #include "map"
 class Reassembler {
    public:
     // Construct Reassembler to write into given ByteStream.
+    // A ring-backed output gets the bitmap engine, a chunked one the slice engine (see below).
     explicit Reassembler(ByteStream&& output)
-        : output_(std::move(output)), map_(), isGetLastString(false), nextIndex(0) {}
+        : output_(std::move(output)), nextIndex(0), useBitmap_(output_.storage() == ByteStream::Storage::Ring) {}
 
     /*
      * Insert a new substring to be reassembled into a ByteStream.
@@ -30,10 +37,32 @@ class Reassembler {
      */
     void insert(uint64_t first_index, std::string data, bool is_last_substring);
 
-    // How many bytes are stored in the Reassembler itself?
-    // This function is for testing only; don't add extra state to support it.
+    // Insert a burst of substrings at once (e.g. all the segments read in one wakeup). The batch is sorted,
+    // the window is checked once, and the contiguous prefix it forms is pushed to the output in one go.
+    // The segments are reordered and their data consumed.
+    struct Segment {
+        uint64_t first_index{};
+        std::string data{};
+        bool is_last_substring{};
+    };
+    void insert_batch(std::span<Segment> segments);
+
+    // How many bytes are stored in the Reassembler itself? (O(1): kept up to date by each insert)
     uint64_t count_bytes_pending() const;
 
+    // The bytes held beyond the first unassembled index, as maximal runs of consecutive stream indices
+    // in increasing order; the gaps between them (and before the first) are what is still missing.
+    // Only the first `max_ranges` runs are found, so asking for a few stays cheap.
+    struct Range {
+        uint64_t first_index{};
+        uint64_t length{};
+        bool operator==(const Range& other) const = default;
+    };
+    std::vector<Range> received_ranges(size_t max_ranges) const;
+
+    // The run of held bytes that includes stream index `index`, if that byte is held.
+    std::optional<Range> received_range_at(uint64_t index) const;
+
     // Access output stream reader
     Reader& reader() { return output_.reader(); }
     const Reader& reader() const { return output_.reader(); }
@@ -43,14 +72,39 @@ class Reassembler {
 
    private:
     ByteStream output_;
-    std::map<uint64_t, std::string> map_;
-    bool isGetLastString;
-    uint64_t nextIndex;
+    uint64_t nextIndex;                   // first unassembled index
+    uint64_t pending_{};                  // bytes held by the Reassembler (by whichever engine)
+    std::optional<uint64_t> endIndex_{};  // stream index just past the last byte, once known
 
-   private:
-    inline void setIsLastStr(bool is_last_substring, uint64_t index1, uint64_t index2) {
-        if (is_last_substring && index1 == index2) {
-            isGetLastString = true;
-        }
-    }
+    void pushRun(std::span<Segment> run, uint64_t length);
+
+    // Bitmap engine: each out-of-order byte is written straight into its final place in the output stream's
+    // free space (Writer::write_at), and its bit is set in `present_` at (stream index mod bitmapSize_).
+    // The contiguous prefix is then found by scanning the bitmap a word at a time and made readable with
+    // Writer::advance, so an insert costs O(bytes) with no allocation, no search and no second copy, however
+    // reordered the segments. The Reassembler itself holds only the bitmap (one bit per byte of capacity),
+    // and only while bytes are pending.
+    bool useBitmap_;
+    uint64_t bitmapSize_{};  // power of two no smaller than the stream's capacity
+    std::vector<uint64_t> present_{};
+
+    void storeBitmap(uint64_t first_index, std::string_view data);
+    void forgetBitmap(uint64_t first_index, uint64_t length);
+    void flushBitmap();
+
+    // Slice engine: an out-of-order payload is kept as is (moved in, never copied), shared by reference
+    // count between the slices that point into it. Overlaps are resolved by narrowing slices, and a
+    // slice that still spans its whole payload is moved, not copied, into the (chunked) output. Like the
+    // chunks of the output stream, the payloads are the caller's own strings, not BufferPool buffers.
+    struct Slice {
+        std::shared_ptr<std::string> payload;
+        uint64_t offset;
+        uint64_t length;
+    };
+    std::map<uint64_t, Slice> slices_{};  // keyed by stream index; never overlapping
+
+    void storeSlices(uint64_t first_index, uint64_t begin, uint64_t end, std::string data);
+    void forgetSlices(uint64_t end);
+    void flushSlices();
+    static std::string takeSlice(Slice& slice);
 };
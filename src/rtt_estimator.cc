@@ -0,0 +1,40 @@
+#include "rtt_estimator.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+RTTEstimator::RTTEstimator( uint64_t initial_rto_ms, uint64_t min_rto_ms, uint64_t max_rto_ms )
+  : min_rto_ms_( min_rto_ms ), max_rto_ms_( max_rto_ms ), rto_ms_( initial_rto_ms )
+{}
+
+void RTTEstimator::sample( uint64_t rtt_ms )
+{
+  constexpr double alpha = 1.0 / 8;
+  constexpr double beta = 1.0 / 4;
+
+  const auto r = static_cast<double>( rtt_ms );
+  if ( samples_ == 0 ) {
+    srtt_ms_ = r;
+    rttvar_ms_ = r / 2;
+  } else {
+    // RTTVAR is updated first, with the old SRTT
+    rttvar_ms_ = ( 1 - beta ) * rttvar_ms_ + beta * abs( srtt_ms_ - r );
+    srtt_ms_ = ( 1 - alpha ) * srtt_ms_ + alpha * r;
+  }
+  ++samples_;
+
+  const auto rto = static_cast<uint64_t>( ceil( srtt_ms_ + max( clock_granularity_ms, 4 * rttvar_ms_ ) ) );
+  rto_ms_ = clamp( rto, min_rto_ms_, max_rto_ms_ );
+}
+
+uint64_t RTTEstimator::backoff( uint64_t rto_ms ) const
+{
+  return rto_ms > max_rto_ms_ / 2 ? max( rto_ms, max_rto_ms_ ) : 2 * rto_ms;
+}
+
+RTTEstimator::Estimate RTTEstimator::estimate() const
+{
+  return { .samples = samples_, .srtt_ms = srtt_ms_, .rttvar_ms = rttvar_ms_, .rto_ms = rto_ms_ };
+}
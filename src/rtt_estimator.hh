@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+// Round-trip time estimation and the retransmission timeout it implies (RFC 6298, section 2).
+//
+// Until the first sample the RTO is the initial value. Each sample R updates the smoothed round-trip time
+// and its variation (SRTT, RTTVAR), and the RTO becomes SRTT + max(G, 4 * RTTVAR), rounded up to whole
+// milliseconds and clamped to [min_rto_ms, max_rto_ms]. G, the clock granularity, is one millisecond: the
+// sender only learns about time through tick().
+//
+// The caller is responsible for Karn's algorithm: never sample a segment that was retransmitted.
+class RTTEstimator
+{
+public:
+  struct Estimate
+  {
+    uint64_t samples {};  // RTT samples taken so far
+    double srtt_ms {};    // smoothed round-trip time (0 until the first sample)
+    double rttvar_ms {};  // round-trip time variation (0 until the first sample)
+    uint64_t rto_ms {};   // retransmission timeout
+  };
+
+  static constexpr double clock_granularity_ms = 1;
+
+  RTTEstimator( uint64_t initial_rto_ms, uint64_t min_rto_ms, uint64_t max_rto_ms );
+
+  void sample( uint64_t rtt_ms );             // Fold in one round-trip measurement
+  uint64_t rto_ms() const { return rto_ms_; } // RTO for a timer started now
+  uint64_t backoff( uint64_t rto_ms ) const;  // RTO after a timeout: doubled, up to max_rto_ms
+  Estimate estimate() const;                  // Snapshot of the current estimates
+
+private:
+  uint64_t min_rto_ms_;
+  uint64_t max_rto_ms_;
+  uint64_t rto_ms_;
+  uint64_t samples_ {};
+  double srtt_ms_ {};
+  double rttvar_ms_ {};
+};
@@ -2,6 +2,8 @@
 
 #include "debug.hh"
 
+#include <algorithm>
+
 using namespace std;
 
 void TCPReceiver::receive(TCPSenderMessage message) {
@@ -10,12 +12,52 @@ void TCPReceiver::receive(TCPSenderMessage message) {
     }
     if (message.SYN) {
         zero_point.emplace(message.seqno);
-        reassembler_.insert(0, message.payload, message.FIN);
+        reassembler_.insert(0, std::move(message.payload), message.FIN);
     } else if (zero_point != std::nullopt) {
         uint64_t first_index =
             message.seqno.unwrap(zero_point.value(), reassembler_.writer().bytes_pushed()) - 1;
-        reassembler_.insert(first_index, message.payload, message.FIN);
+        const bool has_payload = !message.payload.empty();
+        reassembler_.insert(first_index, std::move(message.payload), message.FIN);
+        if (send_sack_ && has_payload && first_index > reassembler_.writer().bytes_pushed()) {
+            noteOutOfOrder(first_index);
+        }
+    }
+}
+
+void TCPReceiver::noteOutOfOrder(uint64_t first_index) {
+    recent_.insert(recent_.begin(), first_index);
+    vector<uint64_t> kept;
+    sackRanges(&kept);
+    recent_ = std::move(kept);
+}
+
+vector<Reassembler::Range> TCPReceiver::sackRanges(vector<uint64_t>* kept) const {
+    vector<Reassembler::Range> ranges;
+    // The ranges holding recent segments, newest first. An index may since have been acknowledged (or
+    // dropped, if it was beyond the window), or joined the range of a newer one.
+    for (const uint64_t index : recent_) {
+        const auto range = reassembler_.received_range_at(index);
+        if (!range || find(ranges.begin(), ranges.end(), *range) != ranges.end()) {
+            continue;
+        }
+        ranges.push_back(*range);
+        if (kept != nullptr) {
+            kept->push_back(index);
+        }
+        if (ranges.size() == TCPReceiverMessage::MAX_SACK_BLOCKS) {
+            return ranges;
+        }
     }
+    // Any blocks left over go to the lowest ranges not yet reported; the lowest MAX_SACK_BLOCKS are enough
+    for (const auto& range : reassembler_.received_ranges(TCPReceiverMessage::MAX_SACK_BLOCKS)) {
+        if (ranges.size() == TCPReceiverMessage::MAX_SACK_BLOCKS) {
+            break;
+        }
+        if (find(ranges.begin(), ranges.end(), range) == ranges.end()) {
+            ranges.push_back(range);
+        }
+    }
+    return ranges;
 }
 
 TCPReceiverMessage TCPReceiver::send() const {
@@ -26,7 +68,16 @@ TCPReceiverMessage TCPReceiver::send() const {
     if (zero_point == std::nullopt) {
         return {std::nullopt, window_size, reassembler_.reader().has_error()};
     }
-    return {std::optional<Wrap32>(Wrap32::wrap(reassembler_.writer().bytes_pushed() + 1, zero_point.value()) +
-                                  reassembler_.writer().is_closed()),
-            window_size, reassembler_.reader().has_error()};
+    TCPReceiverMessage msg{
+        std::optional<Wrap32>(Wrap32::wrap(reassembler_.writer().bytes_pushed() + 1, zero_point.value()) +
+                              reassembler_.writer().is_closed()),
+        window_size, reassembler_.reader().has_error()};
+    if (send_sack_) {
+        // Stream index i is absolute seqno i + 1 (the SYN comes first)
+        for (const auto& range : sackRanges()) {
+            msg.sack.push_back({Wrap32::wrap(range.first_index + 1, zero_point.value()),
+                                Wrap32::wrap(range.first_index + 1 + range.length, zero_point.value())});
+        }
+    }
+    return msg;
 }
@@ -1,15 +1,16 @@
 #pragma once
 
 #include <optional>
+#include <vector>
 
 #include "reassembler.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 class TCPReceiver {
    public:
-    // Construct with given Reassembler
-    explicit TCPReceiver(Reassembler&& reassembler)
-        : reassembler_(std::move(reassembler)), zero_point{std::nullopt} {}
+    // Construct with given Reassembler; with `send_sack`, acknowledgments also carry SACK blocks
+    explicit TCPReceiver(Reassembler&& reassembler, bool send_sack = false)
+        : reassembler_(std::move(reassembler)), zero_point{std::nullopt}, send_sack_(send_sack) {}
 
     /*
      * The TCPReceiver receives TCPSenderMessages, inserting their payload into the Reassembler
@@ -29,4 +30,13 @@ class TCPReceiver {
    private:
     Reassembler reassembler_;
     std::optional<Wrap32> zero_point;
+    bool send_sack_;
+
+    // Stream indices of the latest out-of-order segments, newest first, at most one per range of held
+    // bytes. Their ranges lead the SACK blocks, so that the first block reports the most recent segment
+    // and the others repeat the most recently reported ones (RFC 2018 section 4).
+    std::vector<uint64_t> recent_{};
+
+    void noteOutOfOrder(uint64_t first_index);
+    std::vector<Reassembler::Range> sackRanges(std::vector<uint64_t>* kept = nullptr) const;
 };
@@ -1,6 +1,7 @@
 #include "tcp_sender.hh"
 
 #include <algorithm>
+#include <cmath>
 #include <optional>
 
 #include "debug.hh"
@@ -11,15 +12,216 @@ using namespace std;
 // This function is for testing only; don't add extra state to support it.
 uint64_t TCPSender::sequence_numbers_in_flight() const { return num_in_flight_; }
 
+RTTEstimator::Estimate TCPSender::rtt_estimate() const {
+    RTTEstimator::Estimate estimate = rtt_.estimate();
+    estimate.rto_ms = RTO_ms_;
+    return estimate;
+}
+
+uint64_t TCPSender::cwnd() const { return cc_ ? cc_->cwnd() : UINT64_MAX; }
+
+uint64_t TCPSender::ssthresh() const { return cc_ ? cc_->ssthresh() : UINT64_MAX; }
+
+std::optional<uint64_t> TCPSender::pacing_delay_ms() const {
+    if (!paced_) {
+        return std::nullopt;
+    }
+    return static_cast<uint64_t>(std::max(std::floor(next_send_ms_) - static_cast<double>(now_ms_), 0.0));
+}
+
+double TCPSender::pacingRate() const {
+    const RTTEstimator::Estimate estimate = rtt_.estimate();
+    if (!pacing_ || estimate.samples == 0) {
+        return 0;
+    }
+    const bool slow_start = cc_ && cc_->cwnd() < cc_->ssthresh();
+    const double gain = slow_start ? pacing_ss_gain_ : pacing_ca_gain_;
+    const auto window = static_cast<double>(std::min(recvwindow_size_, cwnd()));
+    // An RTT below the clock's granularity still spans one tick
+    return gain * window / std::max(estimate.srtt_ms, RTTEstimator::clock_granularity_ms);
+}
+
+bool TCPSender::pacingAllows() const {
+    // The clock counts whole milliseconds, so anything due before the next one goes now
+    return pacingRate() == 0 || next_send_ms_ < static_cast<double>(now_ms_ + 1);
+}
+
+void TCPSender::onPacedSend(uint64_t length) {
+    const double rate = pacingRate();
+    if (rate > 0) {
+        next_send_ms_ = std::max(next_send_ms_, static_cast<double>(now_ms_)) + static_cast<double>(length) / rate;
+    }
+}
+
+bool TCPSender::holdShortSegment(uint64_t length) {
+    if (length >= TCPConfig::MAX_PAYLOAD_SIZE || input_.writer().is_closed() ||
+        input_.reader().bytes_popped() < flush_until_) {
+        return false;
+    }
+    if (cork_) {
+        if (!corked_since_ms_) {
+            corked_since_ms_ = now_ms_;
+        }
+        return now_ms_ - *corked_since_ms_ < cork_timeout_ms_;
+    }
+    // Nagle (RFC 896): a short segment waits while any sent data, full-sized or not, is unacknowledged
+    return nagle_ && num_in_flight_ > 0;
+}
+
+uint64_t TCPSender::sendWindow() const {
+    const uint64_t window = recvwindow_size_ > 0 ? recvwindow_size_ : 1;
+    // Sequence numbers that have left the network don't count against the congestion window
+    const uint64_t left_network = recovery_inflation_ + sacked_seqnos_ + lost_seqnos_;
+    return cc_ ? std::min(window, cc_->cwnd() + left_network) : window;
+}
+
+void TCPSender::onDuplicateAck() {
+    dup_acks_++;
+    if (in_recovery_) {
+        // Another segment has left the network (with SACK, the scoreboard knows which)
+        if (!sack_) {
+            recovery_inflation_ += TCPConfig::MAX_PAYLOAD_SIZE;
+        }
+        return;
+    }
+    // Only one fast retransmit per window of data (RFC 6582 section 3.2, step 2)
+    if (dup_acks_ == 3 && recv_seqno_ > recover_) {
+        enterRecovery();
+    }
+}
+
+void TCPSender::enterRecovery() {
+    in_recovery_ = true;
+    recover_ = next_seqno_;
+    if (cc_) {
+        cc_->on_fast_retransmit(now_ms_, num_in_flight_);
+    }
+    // The first hole is retransmitted whatever the window (RFC 6675 section 5, step 4.3)
+    retransmit_pending_ = true;
+    if (sack_) {
+        detectLosses();
+    } else {
+        recovery_inflation_ = 3 * TCPConfig::MAX_PAYLOAD_SIZE;
+    }
+}
+
+void TCPSender::onNewAck(uint64_t abs_ackno, uint64_t bytes_acked) {
+    dup_acks_ = 0;
+    if (!in_recovery_) {
+        return;
+    }
+    if (abs_ackno >= recover_) {
+        // Full acknowledgment: leave recovery with the window congestion control set on entry
+        in_recovery_ = false;
+        recovery_inflation_ = 0;
+        return;
+    }
+    // Partial acknowledgment: the next hole is lost too. With SACK, mark it for the scoreboard to resend;
+    // otherwise deflate by the data acknowledged, keeping one segment for the retransmission.
+    if (sack_) {
+        if (!outstanding_.empty() && !outstanding_.front().retransmitted) {
+            markLost(outstanding_.front());
+        }
+        return;
+    }
+    recovery_inflation_ -= std::min(recovery_inflation_, bytes_acked);
+    recovery_inflation_ += TCPConfig::MAX_PAYLOAD_SIZE;
+    retransmit_pending_ = !outstanding_.empty();
+}
+
+void TCPSender::updateScoreboard(const TCPReceiverMessage& msg) {
+    for (const auto& block : msg.sack) {
+        const uint64_t left = block.left.unwrap(isn_, recv_seqno_);
+        const uint64_t right = block.right.unwrap(isn_, recv_seqno_);
+        // Ignore blocks at or below the ackno (e.g. stale ones), and any beyond what has been sent
+        if (left <= recv_seqno_ || right <= left || right > next_seqno_) {
+            continue;
+        }
+        const auto starts_before = [](const Outstanding& segment, uint64_t seqno) { return segment.seqno < seqno; };
+        auto it = std::lower_bound(outstanding_.begin(), outstanding_.end(), left, starts_before);
+        for (; it != outstanding_.end() && it->seqno + it->message.sequence_length() <= right; ++it) {
+            if (it->sacked) {
+                continue;
+            }
+            const uint64_t length = it->message.sequence_length();
+            if (it->lost) {
+                it->lost = false;
+                lost_seqnos_ -= length;
+            }
+            it->sacked = true;
+            sacked_seqnos_ += length;
+            sacked_segments_++;
+        }
+    }
+}
+
+void TCPSender::detectLosses() {
+    // From the newest segment back to the oldest, so the SACKed segments above each one have been counted
+    // (a burst of holes lies below the lowest SACKed segment)
+    uint64_t sacked_above = 0;
+    for (auto it = outstanding_.rbegin(); it != outstanding_.rend(); ++it) {
+        if (it->sacked) {
+            sacked_above++;
+        } else if (sacked_above >= 3 && !it->retransmitted) {
+            markLost(*it);
+        }
+    }
+}
+
+void TCPSender::markLost(Outstanding& segment) {
+    if (!segment.sacked && !segment.lost) {
+        segment.lost = true;
+        lost_seqnos_ += segment.message.sequence_length();
+    }
+}
+
+void TCPSender::retransmitLost(const TransmitFunction& transmit) {
+    for (auto& segment : outstanding_) {
+        if (lost_seqnos_ == 0) {
+            break;
+        }
+        if (!segment.lost) {
+            continue;
+        }
+        // The pipe: sequence numbers in flight that haven't left the network
+        if (cc_ && num_in_flight_ - sacked_seqnos_ - lost_seqnos_ >= cc_->cwnd()) {
+            break;
+        }
+        if (!pacingAllows()) {
+            paced_ = true;
+            break;
+        }
+        retransmit(segment, transmit);
+        onPacedSend(segment.message.sequence_length());
+    }
+}
+
+void TCPSender::retransmit(Outstanding& segment, const TransmitFunction& transmit) {
+    transmit(segment.message);
+    segment.retransmitted = true;
+    if (segment.lost) {
+        segment.lost = false;
+        lost_seqnos_ -= segment.message.sequence_length();
+    }
+}
+
 // This function is for testing only; don't add extra state to support it.
 uint64_t TCPSender::consecutive_retransmissions() const { return consecutive_retransmissions_; }
 
 void TCPSender::push(const TransmitFunction& transmit) {
+    paced_ = false;
+    if (retransmit_pending_ && !outstanding_.empty()) {
+        retransmit_pending_ = false;
+        retransmit(outstanding_.front(), transmit);
+    }
+    if (lost_seqnos_ > 0) {
+        retransmitLost(transmit);
+    }
     if (send_FIN) {  // 齻ش tick
         return;
     }
     // õʹõĿռС
-    uint16_t window_size = (recvwindow_size_ > 0 ? recvwindow_size_ : 1);
+    uint64_t window_size = sendWindow();
     TCPSenderMessage message;
     if (!send_SYN) {
         message.SYN = true;
@@ -37,15 +239,9 @@ void TCPSender::push(const TransmitFunction& transmit) {
             send_FIN = true;
             next_seqno_++;
         }
-        transmit(message);
         // ״̬
         send_SYN = true;
-        num_in_flight_ += message.sequence_length();
-        wait_ack_sendmsgs.push(message);
-        if (!is_alarm_running) {
-            is_alarm_running = true;
-            sum_of_time = 0;
-        }
+        sendSegment(std::move(message), 0, transmit);
         return;
     }
     // ͽһFIN
@@ -53,41 +249,55 @@ void TCPSender::push(const TransmitFunction& transmit) {
         message.FIN = true;
         message.RST = input_.has_error();
         message.seqno = Wrap32::wrap(next_seqno_, isn_);
-        transmit(message);
         // ״̬
-        num_in_flight_ += message.sequence_length();
-        wait_ack_sendmsgs.push(message);
         send_FIN = true;
+        sendSegment(std::move(message), next_seqno_, transmit);
         next_seqno_++;
-        if (!is_alarm_running) {
-            is_alarm_running = true;
-            sum_of_time = 0;
-        }
     }
     // ѭֱͣµֽҪȡ޿ÿռ
     while (input_.reader().bytes_buffered() && recv_seqno_ + window_size > next_seqno_) {
+        if (!pacingAllows()) {
+            paced_ = true;
+            break;
+        }
+        TCPSenderMessage segment;
+        const uint64_t seqno = next_seqno_;
         // ݴСȡ
         size_t send_size = std::min(TCPConfig::MAX_PAYLOAD_SIZE,
                                     static_cast<size_t>(window_size - (next_seqno_ - recv_seqno_)));
-        read(input_.reader(), std::min(send_size, input_.reader().bytes_buffered()), message.payload);
-        message.seqno = Wrap32::wrap(next_seqno_, isn_);
-        message.RST = input_.has_error();
-        next_seqno_ += message.sequence_length();
+        send_size = std::min(send_size, static_cast<size_t>(input_.reader().bytes_buffered()));
+        if (holdShortSegment(send_size)) {
+            break;
+        }
+        corked_since_ms_.reset();
+        read(input_.reader(), send_size, segment.payload);
+        segment.seqno = Wrap32::wrap(next_seqno_, isn_);
+        segment.RST = input_.has_error();
+        next_seqno_ += segment.sequence_length();
         // ˣFIN־
         if (input_.reader().is_finished() && recv_seqno_ + window_size > next_seqno_) {
-            message.FIN = true;
+            segment.FIN = true;
             send_FIN = true;
             next_seqno_++;
         }
         // ͱ
-        transmit(message);
-        // ״̬
-        num_in_flight_ += message.sequence_length();
-        wait_ack_sendmsgs.push(message);
-        if (!is_alarm_running) {
-            is_alarm_running = true;
-            sum_of_time = 0;
-        }
+        sendSegment(std::move(segment), seqno, transmit);
+        onPacedSend(next_seqno_ - seqno);
+    }
+}
+
+void TCPSender::flush(const TransmitFunction& transmit) {
+    flush_until_ = input_.writer().bytes_pushed();
+    push(transmit);
+}
+
+void TCPSender::sendSegment(TCPSenderMessage&& message, uint64_t seqno, const TransmitFunction& transmit) {
+    transmit(message);
+    num_in_flight_ += message.sequence_length();
+    outstanding_.push_back({seqno, std::move(message), now_ms_, delivered_, false, false, false});
+    if (!is_alarm_running) {
+        is_alarm_running = true;
+        sum_of_time = 0;
     }
 }
 
@@ -98,7 +308,7 @@ TCPSenderMessage TCPSender::make_empty_message() const {
     return msg;
 }
 
-void TCPSender::receive(const TCPReceiverMessage& msg) {
+void TCPSender::receive(const TCPReceiverMessage& msg, bool carries_data) {
     if (msg.RST) {
         input_.set_error();
         return;
@@ -112,41 +322,117 @@ void TCPSender::receive(const TCPReceiverMessage& msg) {
     if (abs_ackno > next_seqno_) {
         return;
     }
+    // A duplicate ACK (RFC 5681) repeats the last ackno and window while data is outstanding
+    const bool duplicate = !carries_data && abs_ackno == recv_seqno_ && msg.window_size == recvwindow_size_ &&
+                           !outstanding_.empty();
+    const bool advanced = abs_ackno > recv_seqno_;
     // µĴڴС
     if (abs_ackno >= recv_seqno_) {
         recv_seqno_ = abs_ackno;
         recvwindow_size_ = msg.window_size;
     }
     // ɾѾȷϷͳɹ
-    while (!wait_ack_sendmsgs.empty()) {
-        TCPSenderMessage send_msg = wait_ack_sendmsgs.front();
+    bool acked_new_data = false;
+    bool acked_retransmission = false;
+    uint64_t bytes_acked = 0;
+    uint64_t newest_sent_at_ms = 0;
+    uint64_t newest_delivered_at_send = 0;
+    while (!outstanding_.empty()) {
+        const uint64_t length = outstanding_.front().message.sequence_length();
         // ǰͷĶλδͳɹ
-        if (abs_ackno < send_msg.seqno.unwrap(isn_, next_seqno_) + send_msg.sequence_length()) return;
+        if (abs_ackno < outstanding_.front().seqno + length) break;
 
         // ͳɹҪУ޸ķ͵ݴС
-        wait_ack_sendmsgs.pop();
-        num_in_flight_ -= send_msg.sequence_length();
+        acked_new_data = true;
+        acked_retransmission |= outstanding_.front().retransmitted;
+        bytes_acked += outstanding_.front().message.payload.size();
+        newest_sent_at_ms = outstanding_.front().sent_at_ms;
+        newest_delivered_at_send = outstanding_.front().delivered_at_send;
+        if (outstanding_.front().sacked) {
+            sacked_seqnos_ -= length;
+            sacked_segments_--;
+        }
+        if (outstanding_.front().lost) {
+            lost_seqnos_ -= length;
+        }
+        outstanding_.pop_front();
+        num_in_flight_ -= length;
         // شʱʱ䡢ششʱ
-        RTO_ms_ = initial_RTO_ms_;
         consecutive_retransmissions_ = 0;
         sum_of_time = 0;
     }
+    if (sack_) {
+        updateScoreboard(msg);
+    }
+    // Time the ACK unless it covers a retransmitted segment (Karn's algorithm). Either way, new data brings
+    // the RTO back from any backoff to the estimate: only the front segment is retransmitted on a timeout,
+    // so keeping the backoff until the next valid sample would let each further loss in the window double it.
+    std::optional<uint64_t> rtt_sample;
+    if (acked_new_data && !acked_retransmission) {
+        rtt_sample = now_ms_ - newest_sent_at_ms;
+        if (adaptive_RTO_ || pacing_) {
+            rtt_.sample(*rtt_sample);
+        }
+    }
+    if (acked_new_data) {
+        RTO_ms_ = adaptive_RTO_ ? rtt_.rto_ms() : initial_RTO_ms_;
+    }
+    // Congestion control doesn't grow the window during fast recovery, nor with the ACK that ends it
+    const bool was_in_recovery = in_recovery_;
+    if (fast_retransmit_ && duplicate) {
+        onDuplicateAck();
+    } else if (fast_retransmit_ && advanced) {
+        onNewAck(abs_ackno, bytes_acked);
+    }
+    // With SACK, three segments SACKed above the first unacknowledged one also start recovery (it is lost
+    // whether or not three duplicate ACKs made it back), and in recovery each ACK may show more holes
+    if (sack_ && in_recovery_) {
+        detectLosses();
+    } else if (sack_ && sacked_segments_ >= 3 && recv_seqno_ > recover_) {
+        enterRecovery();
+    }
+    if (acked_new_data) {
+        delivered_ += bytes_acked;
+        if (cc_ && !was_in_recovery) {
+            cc_->on_ack({now_ms_, bytes_acked, num_in_flight_, delivered_, rtt_sample, newest_delivered_at_send});
+        }
+    }
     // شʱǷȡڷͷǷδɵ
-    is_alarm_running = !wait_ack_sendmsgs.empty();
+    is_alarm_running = !outstanding_.empty();
 }
 
 void TCPSender::tick(uint64_t ms_since_last_tick, const TransmitFunction& transmit) {
+    now_ms_ += ms_since_last_tick;
+    // Send what pacing held back, now that it may be due, and what the cork held back once its timer expires
+    if (paced_ || (corked_since_ms_ && now_ms_ - *corked_since_ms_ >= cork_timeout_ms_)) {
+        push(transmit);
+    }
     if (!is_alarm_running) {
         return;
     }
     sum_of_time += ms_since_last_tick;
-    if (sum_of_time >= RTO_ms_ && !wait_ack_sendmsgs.empty()) {
+    if (sum_of_time >= RTO_ms_ && !outstanding_.empty()) {
         // ش
-        transmit(wait_ack_sendmsgs.front());
+        retransmit(outstanding_.front(), transmit);
         sum_of_time = 0;
         if (recvwindow_size_ > 0) {
             consecutive_retransmissions_++;
-            RTO_ms_ *= 2;
+            RTO_ms_ = rtt_.backoff(RTO_ms_);
+            if (cc_) {
+                cc_->on_timeout(now_ms_, num_in_flight_);
+            }
+            // A timeout ends fast recovery; no fast retransmit until what has been sent is acknowledged
+            in_recovery_ = false;
+            recovery_inflation_ = 0;
+            dup_acks_ = 0;
+            recover_ = next_seqno_;
+            // With SACK, everything else the peer doesn't hold is presumed lost too; push() resends it as
+            // the window opens, skipping the SACKed segments
+            if (sack_) {
+                for (auto it = outstanding_.begin() + 1; it != outstanding_.end(); ++it) {
+                    markLost(*it);
+                }
+            }
         }
     }
 }
\ No newline at end of file
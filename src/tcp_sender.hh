@@ -1,9 +1,15 @@
 #pragma once
 
+#include <cstdint>
+#include <deque>
 #include <functional>
-#include <queue>
+#include <memory>
+#include <optional>
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "rtt_estimator.hh"
+#include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 
@@ -21,22 +27,72 @@ class TCPSender {
           isn_(isn),
           send_SYN(false),
           send_FIN(false),
-          wait_ack_sendmsgs(),
+          outstanding_(),
+          rtt_(initial_RTO_ms, 0, UINT64_MAX),
+          adaptive_RTO_(false),
           initial_RTO_ms_(initial_RTO_ms),
           RTO_ms_(initial_RTO_ms),
           is_alarm_running(false),
           consecutive_retransmissions_(0),
           sum_of_time(0),
+          now_ms_(0),
+          cc_(),
+          delivered_(0),
+          fast_retransmit_(false),
+          dup_acks_(0),
+          in_recovery_(false),
+          recover_(0),
+          recovery_inflation_(0),
+          retransmit_pending_(false),
+          sack_(false),
+          sacked_seqnos_(0),
+          sacked_segments_(0),
+          lost_seqnos_(0),
+          pacing_(false),
+          pacing_ss_gain_(1),
+          pacing_ca_gain_(1),
+          next_send_ms_(0),
+          paced_(false),
+          nagle_(false),
+          cork_(false),
+          cork_timeout_ms_(0),
+          corked_since_ms_(),
+          flush_until_(0),
           next_seqno_(0),
           recv_seqno_(0),
           recvwindow_size_(1),
           num_in_flight_(0) {}
 
+    /**
+     * Construct TCP sender from a TCPConfig: its ISN, initial RTO, retransmission-timer options,
+     * congestion control and loss recovery
+     *
+     * @param input ByteStream of outbound data
+     * @param config the connection's configuration
+     */
+    TCPSender(ByteStream&& input, const TCPConfig& config)
+        : TCPSender(std::move(input), config.isn, config.rt_timeout) {
+        if (config.adaptive_rto) {
+            rtt_ = RTTEstimator(config.rt_timeout, config.min_rto, config.max_rto);
+            adaptive_RTO_ = true;
+        }
+        cc_ = CongestionControl::make(config.congestion_control, TCPConfig::MAX_PAYLOAD_SIZE);
+        fast_retransmit_ = config.fast_retransmit || config.sack;
+        sack_ = config.sack;
+        pacing_ = config.pacing;
+        pacing_ss_gain_ = config.pacing_ss_gain;
+        pacing_ca_gain_ = config.pacing_ca_gain;
+        nagle_ = !config.nodelay;
+        cork_ = config.cork;
+        cork_timeout_ms_ = config.cork_timeout;
+    }
+
     /* Generate an empty TCPSenderMessage */
     TCPSenderMessage make_empty_message() const;
 
-    /* Receive and process a TCPReceiverMessage from the peer's receiver */
-    void receive(const TCPReceiverMessage& msg);
+    /* Receive and process a TCPReceiverMessage from the peer's receiver (`carries_data` if the segment it
+     * arrived in occupied sequence numbers, so it can't be a duplicate ACK) */
+    void receive(const TCPReceiverMessage& msg, bool carries_data = false);
 
     /* Type of the `transmit` function that the push and tick methods can use to send messages */
     using TransmitFunction = std::function<void(const TCPSenderMessage&)>;
@@ -44,6 +100,10 @@ class TCPSender {
     /* Push bytes from the outbound stream */
     void push(const TransmitFunction& transmit);
 
+    /* Push bytes from the outbound stream, including a short segment that Nagle's algorithm or the cork would
+     * hold back */
+    void flush(const TransmitFunction& transmit);
+
     /* Time has passed by the given # of milliseconds since the last time the tick() method was called */
     void tick(uint64_t ms_since_last_tick, const TransmitFunction& transmit);
 
@@ -51,13 +111,50 @@ class TCPSender {
     uint64_t sequence_numbers_in_flight() const;  // For testing: how many sequence numbers are outstanding?
     uint64_t consecutive_retransmissions()
         const;  // For testing: how many consecutive retransmissions have happened?
+    RTTEstimator::Estimate rtt_estimate() const;  // RTT estimates, and the RTO the timer is using now
+    uint64_t cwnd() const;                        // Congestion window (UINT64_MAX without congestion control)
+    uint64_t ssthresh() const;                    // Slow-start threshold (UINT64_MAX if none)
+    // With pacing holding segments back: milliseconds until the next is due (tick() sends it then)
+    std::optional<uint64_t> pacing_delay_ms() const;
     const Writer& writer() const { return input_.writer(); }
     const Reader& reader() const { return input_.reader(); }
     Writer& writer() { return input_.writer(); }
 
    private:
+    struct Outstanding;  // a segment sent but not yet acknowledged (see outstanding_)
+
     Reader& reader() { return input_.reader(); }
 
+    // The receive window (at least 1, to probe a closed one), limited by the congestion window
+    uint64_t sendWindow() const;
+
+    // Fast retransmit and recovery: a duplicate ACK, and an ACK that moved recv_seqno_ forward
+    void onDuplicateAck();
+    void onNewAck(uint64_t abs_ackno, uint64_t bytes_acked);
+    void enterRecovery();
+
+    // SACK scoreboard: mark the segments the peer holds, mark those deemed lost (RFC 6675 IsLost), and
+    // retransmit the lost ones as the congestion window allows
+    void updateScoreboard(const TCPReceiverMessage& msg);
+    void detectLosses();
+    void markLost(Outstanding& segment);
+    void retransmitLost(const TransmitFunction& transmit);
+
+    // Send an outstanding segment again
+    void retransmit(Outstanding& segment, const TransmitFunction& transmit);
+
+    // Pacing: the rate (bytes per millisecond, 0 if not pacing yet), whether a segment may go now, and
+    // the schedule's update once one has
+    double pacingRate() const;
+    bool pacingAllows() const;
+    void onPacedSend(uint64_t length);
+
+    // Should a new segment of `length` payload bytes wait for more data (Nagle's algorithm, or the cork)?
+    bool holdShortSegment(uint64_t length);
+
+    // Transmit a segment that starts at absolute seqno `seqno`, then hold on to it until it is acknowledged
+    void sendSegment(TCPSenderMessage&& message, uint64_t seqno, const TransmitFunction& transmit);
+
     ByteStream input_;
     Wrap32 isn_;
 
@@ -66,14 +163,74 @@ class TCPSender {
     bool send_FIN;
 
     // ݴ淢ȥbyte segments
-    std::queue<TCPSenderMessage> wait_ack_sendmsgs;
+    // Each segment is moved in once it has been transmitted (transmit only borrows it), so neither sending
+    // nor retransmitting copies a payload. It is kept with its absolute seqno, so an ACK retires segments
+    // from the front by comparing integers, without unwrapping anything.
+    struct Outstanding {
+        uint64_t seqno;  // absolute sequence number of the segment's first seqno
+        TCPSenderMessage message;
+        uint64_t sent_at_ms;         // when it was first sent
+        uint64_t delivered_at_send;  // delivered_ at that time
+        bool retransmitted;          // if so, its ACK can't be timed (Karn's algorithm)
+        bool sacked;                 // the peer holds it (a SACK block covered all of it)
+        bool lost;                   // deemed lost and not retransmitted since
+    };
+    std::deque<Outstanding> outstanding_;
 
     // ʱ(ش)ʱ
+    // RTO_ms_ is the estimator's RTO (or the initial one, without adaptive_RTO_), backed off by any timeouts
+    // since. The estimator only takes samples with adaptive_RTO_ or pacing_, which needs the SRTT.
+    RTTEstimator rtt_;
+    bool adaptive_RTO_;
     uint64_t initial_RTO_ms_;
     uint64_t RTO_ms_;
     bool is_alarm_running;
     uint64_t consecutive_retransmissions_;
     uint64_t sum_of_time;
+    uint64_t now_ms_;  // total time passed to tick()
+
+    // Congestion control (null if none), and the payload bytes acknowledged so far
+    std::unique_ptr<CongestionControl> cc_;
+    uint64_t delivered_;
+
+    // Fast retransmit and NewReno fast recovery (RFC 5681, RFC 6582). Recovery lasts until everything sent
+    // before it began (up to recover_) is acknowledged. Meanwhile the congestion window is inflated by the
+    // segments that duplicate ACKs show have left the network, and each partial ACK retransmits the next
+    // hole. Retransmissions decided in receive() go out on the next push().
+    bool fast_retransmit_;
+    uint64_t dup_acks_;
+    bool in_recovery_;
+    uint64_t recover_;
+    uint64_t recovery_inflation_;
+    bool retransmit_pending_;
+
+    // SACK-based loss recovery (RFC 6675). The segments the peer has SACKed, and those deemed lost but not
+    // yet retransmitted, have left the network: the congestion window limits what remains (the "pipe"), and
+    // lost segments are retransmitted before new data is sent. Outside recovery too, so the first SACKs let
+    // new segments out much as limited transmit would (RFC 3042). A segment is deemed lost when three
+    // segments sent after it have been SACKed, and on a timeout everything not SACKed is.
+    bool sack_;
+    uint64_t sacked_seqnos_;
+    uint64_t sacked_segments_;
+    uint64_t lost_seqnos_;
+
+    // Pacing: each segment is due length / pacingRate() after the one before it (next_send_ms_, on the
+    // tick() clock), or at once after an idle spell. Those that aren't due wait in the stream for tick(),
+    // while paced_ says one is waiting.
+    bool pacing_;
+    double pacing_ss_gain_;
+    double pacing_ca_gain_;
+    double next_send_ms_;
+    bool paced_;
+
+    // Nagle's algorithm and the cork hold back a segment shorter than MAX_PAYLOAD_SIZE, unless the stream
+    // is closed or a flush() covers its bytes (those before flush_until_). The cork's timer starts when it
+    // first holds a segment back, and stops whenever one is sent.
+    bool nagle_;
+    bool cork_;
+    uint64_t cork_timeout_ms_;
+    std::optional<uint64_t> corked_since_ms_;
+    uint64_t flush_until_;
 
     // һδʹõкԼյкţ
     uint64_t next_seqno_;
@@ -4,21 +4,19 @@
 
 using namespace std;
 
-Wrap32 Wrap32::wrap(uint64_t n, Wrap32 zero_point) { return zero_point + n; }
-
-uint64_t Wrap32::unwrap(Wrap32 zero_point, uint64_t checkpoint) const {
-    uint64_t temp =
-        ((uint64_t)this->raw_value_ + ((1UL << 32)) - (uint64_t)zero_point.raw_value_) % (1UL << 32) +
-        (checkpoint / (1UL << 32)) * (1UL << 32);
-    if (temp == checkpoint) {
-        return temp;
-    } else if (temp < checkpoint) {
-        uint64_t distance1 = checkpoint - temp;
-        uint64_t distance2 = temp + (1UL << 32) - checkpoint;
-        return distance1 < distance2 ? temp : temp + (1UL << 32);
-    } else {
-        uint64_t distance1 = temp - checkpoint;
-        uint64_t distance2 = (checkpoint + (1UL << 32)) - temp;
-        return distance1 < distance2 ? temp : (temp < (1UL << 32) ? temp : temp - (1UL << 32));
+void Wrap32::unwrap(span<const Wrap32> in, Wrap32 zero_point, uint64_t checkpoint, span<uint64_t> out) {
+    // Work in fixed-size blocks: at -O2 the compiler only vectorises loops whose trip count it knows.
+    constexpr size_t block = 8;
+    const size_t n = in.size() < out.size() ? in.size() : out.size();
+    size_t i = 0;
+    for (; i + block <= n; i += block) {
+        const span<const Wrap32, block> src = in.subspan(i).first<block>();
+        const span<uint64_t, block> dst = out.subspan(i).first<block>();
+        for (size_t j = 0; j < block; j++) {
+            dst[j] = unwrap_raw(src[j].raw_value_ - zero_point.raw_value_, checkpoint);
+        }
+    }
+    for (; i < n; i++) {
+        out[i] = unwrap_raw(in[i].raw_value_ - zero_point.raw_value_, checkpoint);
     }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <span>
 
 /*
  * The Wrap32 type represents a 32-bit unsigned integer that:
@@ -10,10 +11,10 @@
 
 class Wrap32 {
    public:
-    explicit Wrap32(uint32_t raw_value) : raw_value_(raw_value) {}
+    constexpr explicit Wrap32(uint32_t raw_value) : raw_value_(raw_value) {}
 
     /* Construct a Wrap32 given an absolute sequence number n and the zero point. */
-    static Wrap32 wrap(uint64_t n, Wrap32 zero_point);
+    static constexpr Wrap32 wrap(uint64_t n, Wrap32 zero_point) { return zero_point + static_cast<uint32_t>(n); }
 
     /*
      * The unwrap method returns an absolute sequence number that wraps to this Wrap32, given the zero point
@@ -22,11 +23,46 @@ class Wrap32 {
      * There are many possible absolute sequence numbers that all wrap to the same Wrap32.
      * The unwrap method should return the one that is closest to the checkpoint.
      */
-    uint64_t unwrap(Wrap32 zero_point, uint64_t checkpoint) const;
+    constexpr uint64_t unwrap(Wrap32 zero_point, uint64_t checkpoint) const {
+        return unwrap_raw(raw_value_ - zero_point.raw_value_, checkpoint);
+    }
 
-    Wrap32 operator+(uint32_t n) const { return Wrap32{raw_value_ + n}; }
-    bool operator==(const Wrap32& other) const { return raw_value_ == other.raw_value_; }
+    /*
+     * Unwrap an array of sequence numbers against one zero point and checkpoint: out[i] = in[i].unwrap(...),
+     * for each i below both sizes. The loop has no branches, so the compiler can vectorise it.
+     */
+    static void unwrap(std::span<const Wrap32> in, Wrap32 zero_point, uint64_t checkpoint,
+                       std::span<uint64_t> out);
+
+    constexpr Wrap32 operator+(uint32_t n) const { return Wrap32{raw_value_ + n}; }
+    constexpr bool operator==(const Wrap32& other) const { return raw_value_ == other.raw_value_; }
+
+    /*
+     * Ordering in sequence space (RFC 1982 serial number arithmetic): a < b when b is less than 2^31 ahead of a,
+     * as it is for any two seqnos of the same connection that are within a window of each other.
+     */
+    constexpr bool operator<(const Wrap32& other) const {
+        return static_cast<int32_t>(raw_value_ - other.raw_value_) < 0;
+    }
+    constexpr bool operator>(const Wrap32& other) const { return other < *this; }
+    constexpr bool operator<=(const Wrap32& other) const { return !(other < *this); }
+    constexpr bool operator>=(const Wrap32& other) const { return !(*this < other); }
 
    protected:
     uint32_t raw_value_{};
+
+   private:
+    /*
+     * `offset` is this seqno's distance past the zero point, mod 2^32. Of the two candidates on either side of
+     * the checkpoint, take the lower one only when it is strictly closer and does not fall below zero
+     * (so an exact tie goes to the later number). Both tests are done with 64-bit shifts and adds rather than
+     * branches or compares, which every x86-64 vector unit has.
+     */
+    static constexpr uint64_t unwrap_raw(uint32_t offset, uint64_t checkpoint) {
+        const uint64_t ahead = static_cast<uint32_t>(offset - static_cast<uint32_t>(checkpoint));
+        const uint64_t upper = checkpoint + ahead;
+        const uint64_t lower_is_closer = ((uint64_t{1} << 31) - ahead) >> 63;      // ahead > 2^31
+        const uint64_t lower_is_valid = ((upper >> 32) + UINT32_MAX) >> 32;       // upper >= 2^32
+        return upper - ((lower_is_closer & lower_is_valid) << 32);
+    }
 };
@@ -0,0 +1,123 @@
+#include "buffer_pool.hh"
+#include "byte_stream.hh"
+#include "reassembler.hh"
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+void expect( const string& description, uint64_t actual, uint64_t expected )
+{
+  if ( actual != expected ) {
+    throw runtime_error( description + ": expected " + to_string( expected ) + " but got " + to_string( actual ) );
+  }
+}
+
+// Report enough time passing for a drained stream to give back its ring (the first tick only notes the
+// stream's state: it may have been used just now)
+void sit_idle( ByteStream& stream )
+{
+  stream.tick( ByteStream::ring_idle_ms );
+  stream.tick( ByteStream::ring_idle_ms );
+}
+
+void idle_streams_hold_nothing()
+{
+  const uint64_t before = BufferPool::global().stats().bytes_in_use;
+  vector<ByteStream> streams( 1000, ByteStream { 64000 } );
+  expect( "bytes in use by 1000 idle streams", BufferPool::global().stats().bytes_in_use - before, 0 );
+
+  streams[0].writer().push( "hello" );
+  expect( "bytes in use after a small push", BufferPool::global().stats().bytes_in_use - before, 4096 );
+
+  streams[0].writer().push( string( 5000, 'x' ) );
+  expect( "bytes in use after growing", BufferPool::global().stats().bytes_in_use - before, 8192 );
+  if ( streams[0].reader().peek().substr( 0, 5 ) != "hello" ) {
+    throw runtime_error( "growing the ring lost its contents" );
+  }
+
+  streams[0].reader().pop( 5005 );
+  expect( "bytes in use once drained", BufferPool::global().stats().bytes_in_use - before, 8192 );
+  streams[0].tick( ByteStream::ring_idle_ms );
+  streams[0].tick( ByteStream::ring_idle_ms - 1 );
+  expect( "bytes in use when briefly idle", BufferPool::global().stats().bytes_in_use - before, 8192 );
+  streams[0].tick( 1 );
+  expect( "bytes in use once idle", BufferPool::global().stats().bytes_in_use - before, 0 );
+}
+
+void drained_buffers_are_reused()
+{
+  ByteStream stream { 64000 };
+  stream.writer().push( "warm up" );
+  stream.reader().pop( 7 );
+
+  // A stream that keeps draining and refilling holds on to its ring
+  auto before = BufferPool::global().stats();
+  for ( int i = 0; i < 100; ++i ) {
+    stream.writer().push( "abc" );
+    stream.reader().pop( 3 );
+    stream.tick( 1 );
+  }
+  auto after = BufferPool::global().stats();
+  expect( "allocations while cycling", after.allocations - before.allocations, 0 );
+  expect( "reuses while cycling", after.reuses - before.reuses, 0 );
+
+  // Once it has given the ring back, the next push reuses it
+  sit_idle( stream );
+  before = BufferPool::global().stats();
+  stream.writer().push( "abc" );
+  after = BufferPool::global().stats();
+  expect( "allocations after idling", after.allocations - before.allocations, 0 );
+  expect( "reuses after idling", after.reuses - before.reuses, 1 );
+}
+
+void copies_are_independent()
+{
+  ByteStream original { 16 };
+  original.writer().push( "abcdef" );
+  ByteStream copy = original;
+  original.reader().pop( 6 );
+  if ( copy.reader().peek() != "abcdef" ) {
+    throw runtime_error( "copy of a ByteStream did not keep its own bytes" );
+  }
+}
+
+void reassembler_returns_storage()
+{
+  const uint64_t before = BufferPool::global().stats().bytes_in_use;
+  {
+    Reassembler reassembler { ByteStream { 64000 } };
+    reassembler.insert( 1000, string( 1000, 'b' ), false );
+    // Pending bytes are placed in the output stream's ring, which then covers the whole capacity
+    expect( "bytes in use with bytes pending", BufferPool::global().stats().bytes_in_use - before, 65536 );
+    reassembler.insert( 0, string( 1000, 'a' ), false );
+    expect( "bytes in use once reassembled into the stream",
+            BufferPool::global().stats().bytes_in_use - before,
+            65536 );
+    reassembler.reader().pop( 2000 );
+    sit_idle( reassembler.reader() );
+    expect( "bytes in use once read", BufferPool::global().stats().bytes_in_use - before, 0 );
+  }
+  expect( "bytes in use after destruction", BufferPool::global().stats().bytes_in_use - before, 0 );
+}
+} // namespace
+
+int main()
+{
+  try {
+    idle_streams_hold_nothing();
+    drained_buffers_are_reused();
+    copies_are_independent();
+    reassembler_returns_storage();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,124 @@
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+namespace {
+constexpr auto chunked = ByteStream::Storage::Chunked;
+
+void stress_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable-parameters)
+                  const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
+                  const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  default_random_engine rd { random_seed };
+
+  const string data = [&rd, &input_len] {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  ByteStreamTestHarness bs { "chunked stress test input=" + to_string( input_len ) + ", capacity="
+                              + to_string( capacity ),
+                            capacity,
+                            chunked };
+  if ( bs.skipped() ) {
+    return;
+  }
+
+  size_t bytes_pushed {};
+  size_t bytes_popped {};
+  while ( bytes_pushed < data.size() or bytes_popped < data.size() ) {
+    uniform_int_distribution<size_t> bytes_to_push_dist { 0, data.size() - bytes_pushed };
+    const size_t amount_to_push = bytes_to_push_dist( rd );
+    const size_t accepted = min( amount_to_push, capacity - ( bytes_pushed - bytes_popped ) );
+    bs.execute( Push { data.substr( bytes_pushed, amount_to_push ) } );
+    bytes_pushed += accepted;
+    bs.execute( BytesPushed { bytes_pushed } );
+    bs.execute( AvailableCapacity { capacity - ( bytes_pushed - bytes_popped ) } );
+
+    if ( bytes_pushed == data.size() ) {
+      bs.execute( Close {} );
+    }
+
+    const size_t peek_size = bs.peek_size();
+    if ( bytes_pushed != bytes_popped and peek_size == 0 ) {
+      throw runtime_error( "ByteStream::reader().peek() returned empty view" );
+    }
+    bs.execute( PeekOnce { data.substr( bytes_popped, peek_size ) } );
+    bs.execute( PeekAll { data.substr( bytes_popped, bytes_pushed - bytes_popped ) } );
+
+    // Pop across chunk boundaries as well as within one chunk.
+    uniform_int_distribution<size_t> bytes_to_pop_dist { 0, bytes_pushed - bytes_popped };
+    const size_t amount_to_pop = bytes_to_pop_dist( rd );
+    bs.execute( Pop { amount_to_pop } );
+    bytes_popped += amount_to_pop;
+    bs.execute( BytesPopped { bytes_popped } );
+    bs.execute( BytesBuffered { bytes_pushed - bytes_popped } );
+  }
+
+  bs.execute( IsFinished { true } );
+}
+} // namespace
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "chunked peek returns one chunk", 15, chunked };
+      test.execute( Push { "cat" } );
+      test.execute( Push { "" } );
+      test.execute( Push { "tac" } );
+      test.execute( BytesBuffered { 6 } );
+      test.execute( AvailableCapacity { 9 } );
+      test.execute( PeekOnce { "cat" } );
+      test.execute( Peek { "cattac" } );
+      test.execute( Pop { 2 } );
+      test.execute( PeekOnce { "t" } );
+      test.execute( Pop { 2 } );
+      test.execute( PeekOnce { "ac" } );
+      test.execute( BytesPopped { 4 } );
+      test.execute( AvailableCapacity { 13 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "chunked push truncated to capacity", 2, chunked };
+      test.execute( Push { "cat" } );
+      test.execute( BytesPushed { 2 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( PeekOnce { "ca" } );
+      test.execute( Push { "t" } );
+      test.execute( Peek { "ca" } );
+      test.execute( Pop { 1 } );
+      test.execute( Push { "tac" } );
+      test.execute( Peek { "at" } );
+      test.execute( BytesPushed { 3 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "chunked close and finish", 15, chunked };
+      test.execute( Push { "cat" } );
+      test.execute( Close {} );
+      test.execute( IsClosed { true } );
+      test.execute( IsFinished { false } );
+      test.execute( Pop { 5 } );
+      test.execute( BytesPopped { 3 } );
+      test.execute( IsFinished { true } );
+    }
+
+    stress_test( 19, 3, 10110 );
+    stress_test( 1111, 17, 98765 );
+    stress_test( 4097, 4096, 11101 );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
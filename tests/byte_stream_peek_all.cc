@@ -0,0 +1,101 @@
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+namespace {
+void random_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable-parameters)
+                  const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
+                  const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  default_random_engine rd { random_seed };
+
+  const string data = [&rd, &input_len] {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  ByteStreamTestHarness bs { "peek_all input=" + to_string( input_len ) + ", capacity=" + to_string( capacity ),
+                             capacity };
+  if ( bs.skipped() ) {
+    return;
+  }
+
+  size_t bytes_pushed {};
+  size_t bytes_popped {};
+  while ( bytes_pushed < data.size() or bytes_popped < data.size() ) {
+    uniform_int_distribution<size_t> bytes_to_push_dist { 0, data.size() - bytes_pushed };
+    const size_t amount_to_push = bytes_to_push_dist( rd );
+    const size_t accepted = min( amount_to_push, capacity - ( bytes_pushed - bytes_popped ) );
+    bs.execute( Push { data.substr( bytes_pushed, amount_to_push ) } );
+    bytes_pushed += accepted;
+
+    if ( bytes_pushed == data.size() ) {
+      bs.execute( Close {} );
+    }
+
+    // Everything buffered, however the ring has wrapped
+    bs.execute( PeekAll { data.substr( bytes_popped, bytes_pushed - bytes_popped ) } );
+
+    uniform_int_distribution<size_t> bytes_to_pop_dist { 0, bytes_pushed - bytes_popped };
+    const size_t amount_to_pop = bytes_to_pop_dist( rd );
+    bs.execute( Pop { amount_to_pop } );
+    bytes_popped += amount_to_pop;
+    bs.execute( PeekAll { data.substr( bytes_popped, bytes_pushed - bytes_popped ) } );
+  }
+
+  bs.execute( IsFinished { true } );
+}
+} // namespace
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "peek_all on an empty stream", 8 };
+      test.execute( PeekAll { "" } );
+      test.execute( Push { "" } );
+      test.execute( PeekAll { "" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_all across the end of the ring", 8 };
+      test.execute( Push { "abcdef" } );
+      test.execute( Pop { 5 } );
+      test.execute( Push { "ghijkl" } );
+      test.execute( BytesBuffered { 7 } );
+      test.execute( PeekAll { "fghijkl" } );
+      test.execute( Pop { 3 } );
+      test.execute( PeekAll { "ijkl" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_all of a full, wrapped stream", 4 };
+      test.execute( Push { "cat" } );
+      test.execute( Pop { 2 } );
+      test.execute( Push { "tacos" } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( PeekAll { "ttac" } );
+      test.execute( Close {} );
+      test.execute( Pop { 4 } );
+      test.execute( PeekAll { "" } );
+      test.execute( IsFinished { true } );
+    }
+
+    random_test( 19, 3, 10110 );
+    random_test( 1111, 17, 98765 );
+    random_test( 4097, 4096, 11101 );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
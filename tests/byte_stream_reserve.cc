@@ -0,0 +1,93 @@
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+namespace {
+void random_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-parameters)
+                  const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                  const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                  const ByteStream::Storage storage )
+{
+  default_random_engine rd { random_seed };
+
+  const string data = [&rd, &input_len] {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  ByteStreamTestHarness bs {
+    "reserve/commit input=" + to_string( input_len ) + ", capacity=" + to_string( capacity ), capacity, storage };
+  if ( bs.skipped() ) {
+    return;
+  }
+
+  size_t bytes_pushed {};
+  size_t bytes_popped {};
+  while ( bytes_pushed < data.size() or bytes_popped < data.size() ) {
+    uniform_int_distribution<size_t> bytes_to_push_dist { 0, data.size() - bytes_pushed };
+    const size_t amount_to_push = bytes_to_push_dist( rd );
+    bs.execute( ReserveAndCommit { data.substr( bytes_pushed, amount_to_push ) } );
+    bytes_pushed += min( amount_to_push, capacity - ( bytes_pushed - bytes_popped ) );
+    bs.execute( BytesPushed { bytes_pushed } );
+    bs.execute( AvailableCapacity { capacity - ( bytes_pushed - bytes_popped ) } );
+
+    if ( bytes_pushed == data.size() ) {
+      bs.execute( Close {} );
+    }
+
+    bs.execute( PeekAll { data.substr( bytes_popped, bytes_pushed - bytes_popped ) } );
+
+    uniform_int_distribution<size_t> bytes_to_pop_dist { 0, bytes_pushed - bytes_popped };
+    const size_t amount_to_pop = bytes_to_pop_dist( rd );
+    bs.execute( Pop { amount_to_pop } );
+    bytes_popped += amount_to_pop;
+    bs.execute( BytesPopped { bytes_popped } );
+  }
+
+  bs.execute( IsFinished { true } );
+}
+} // namespace
+
+int main()
+{
+  try {
+    for ( const auto storage : { ByteStream::Storage::Ring, ByteStream::Storage::Chunked } ) {
+      {
+        ByteStreamTestHarness test { "reserve across the wrap point", 4, storage };
+        test.execute( Push { "cat" } );
+        test.execute( Pop { 3 } );
+        test.execute( ReserveAndCommit { "tacos" } );
+        test.execute( BytesPushed { 7 } );
+        test.execute( AvailableCapacity { 0 } );
+        test.execute( Peek { "taco" } );
+      }
+
+      {
+        ByteStreamTestHarness test { "reserve interleaved with push", 15, storage };
+        test.execute( Push { "ab" } );
+        test.execute( ReserveAndCommit { "" } );
+        test.execute( Push { "cd" } );
+        test.execute( ReserveAndCommit { "ef" } );
+        test.execute( BytesBuffered { 6 } );
+        test.execute( Peek { "abcdef" } );
+      }
+
+      random_test( 19, 3, 10110, storage );
+      random_test( 1111, 17, 98765, storage );
+      random_test( 4097, 4096, 11101, storage );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
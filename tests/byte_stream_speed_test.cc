@@ -16,7 +16,8 @@ double speed_test( fstream& debug_output,
                    const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
                    const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
                    const size_t write_size,  // NOLINT(bugprone-easily-swappable-parameters)
-                   const size_t read_size )  // NOLINT(bugprone-easily-swappable-parameters)
+                   const size_t read_size,   // NOLINT(bugprone-easily-swappable-parameters)
+                   const ByteStream::Storage storage = ByteStream::Storage::Ring )
 {
   // Generate the data to be written
   const string data = [&random_seed, &input_len] {
@@ -35,7 +36,7 @@ double speed_test( fstream& debug_output,
     split_data.emplace( data.substr( i, write_size ) );
   }
 
-  ByteStream bs { capacity };
+  ByteStream bs { capacity, storage };
   string output_data;
   output_data.reserve( data.size() );
 
@@ -73,13 +74,19 @@ double speed_test( fstream& debug_output,
   auto bits_per_second = 8 * bytes_per_second;
   auto gigabits_per_second = bits_per_second / 1e9;
 
-  cout << "ByteStream with capacity=" << capacity << ", write_size=" << write_size << ", read_size=" << read_size
-       << " reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
+  const string_view storage_s = storage == ByteStream::Storage::Chunked ? "chunked" : "ring";
+
+  cout << "ByteStream (" << storage_s << ") with capacity=" << capacity << ", write_size=" << write_size
+       << ", read_size=" << read_size << " reached " << fixed << setprecision( 2 ) << gigabits_per_second
+       << " Gbit/s.\n";
 
   auto read_s = to_string( read_size );
+  auto capacity_s = to_string( capacity );
   const string fill( 5 - read_s.size(), ' ' );
-  debug_output << "        ByteStream throughput (pop length " << read_s << "):" << fill << fixed
-               << setprecision( 2 ) << setw( 5 ) << gigabits_per_second << " Gbit/s\n";
+  const string capacity_fill( 8 - capacity_s.size(), ' ' );
+  debug_output << "        ByteStream " << setw( 7 ) << storage_s << " throughput (capacity " << capacity_s << ","
+               << capacity_fill << "pop length " << read_s << "):" << fill << fixed << setprecision( 2 )
+               << setw( 5 ) << gigabits_per_second << " Gbit/s\n";
 
   if ( gigabits_per_second < 0.1 ) {
     throw runtime_error( "ByteStream did not meet minimum speed of 0.1 Gbit/s" );
@@ -96,6 +103,15 @@ void program_body()
   speed_test( debug_output, 1e7, 32768, 789, 1500, 4096 );
   speed_test( debug_output, 1e7, 32768, 789, 1500, 128 );
   speed_test( debug_output, 1e7, 32768, 789, 1500, 32 );
+
+  // Small pops should cost the same regardless of how much is buffered behind them.
+  for ( size_t capacity = 4096; capacity <= 16777216; capacity *= 4 ) {
+    speed_test( debug_output, 1e7, capacity, 789, 1500, 32 );
+  }
+
+  speed_test( debug_output, 1e7, 32768, 789, 1500, 4096, ByteStream::Storage::Chunked );
+  speed_test( debug_output, 1e7, 32768, 789, 1500, 128, ByteStream::Storage::Chunked );
+  speed_test( debug_output, 1e7, 32768, 789, 1500, 32, ByteStream::Storage::Chunked );
 }
 
 int main()
@@ -0,0 +1,87 @@
+#include "byte_stream.hh"
+
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+void expect( const string& description, uint64_t actual, uint64_t expected )
+{
+  if ( actual != expected ) {
+    throw runtime_error( description + ": expected " + to_string( expected ) + " but got " + to_string( actual ) );
+  }
+}
+
+void counts_test( ByteStream::Storage storage )
+{
+  ByteStream stream { 10, storage };
+  stream.writer().push( "abcd" );
+  stream.writer().push( "efghijkl" );
+  stream.reader().pop( 3 );
+  stream.reader().pop( 5 );
+  stream.writer().push( "" );
+  stream.reader().pop( 1 );
+
+  const auto stats = stream.reader().stats();
+  expect( "peak_buffered", stats.peak_buffered, 10 );
+  expect( "push_calls", stats.push_calls, 3 );
+  expect( "bytes_pushed", stats.bytes_pushed, 10 );
+  expect( "pop_calls", stats.pop_calls, 3 );
+  expect( "bytes_popped", stats.bytes_popped, 9 );
+  if ( stats.average_push_size() * 3 != 10 or stats.average_pop_size() != 3 ) {
+    throw runtime_error( "wrong average push or pop size" );
+  }
+}
+
+void stall_time_test()
+{
+  constexpr auto spell = milliseconds { 20 };
+
+  ByteStream stream { 4 };
+  this_thread::sleep_for( spell );
+  stream.writer().push( "full" );
+  this_thread::sleep_for( spell );
+  stream.reader().pop( 1 );
+  this_thread::sleep_for( spell );
+
+  const auto stats = stream.reader().stats();
+  if ( stats.time_empty < spell or stats.time_empty >= 3 * spell ) {
+    throw runtime_error( "time_empty should cover only the spell before the first push" );
+  }
+  if ( stats.time_full < spell or stats.time_full >= 3 * spell ) {
+    throw runtime_error( "time_full should cover only the spell between the push and the pop" );
+  }
+
+  // A closed stream is not starving its reader.
+  stream.reader().pop( 3 );
+  stream.writer().close();
+  const auto time_empty = stream.reader().stats().time_empty;
+  this_thread::sleep_for( spell );
+  if ( stream.reader().stats().time_empty != time_empty ) {
+    throw runtime_error( "time_empty should not grow once the stream is closed" );
+  }
+}
+} // namespace
+
+int main()
+{
+  try {
+    if constexpr ( not ByteStream::stats_enabled ) {
+      return EXIT_SUCCESS;
+    }
+    counts_test( ByteStream::Storage::Ring );
+    counts_test( ByteStream::Storage::Chunked );
+    stall_time_test();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
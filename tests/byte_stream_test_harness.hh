@@ -15,8 +15,13 @@ static_assert( sizeof( Writer ) == sizeof( ByteStream ),
 class ByteStreamTestHarness : public TestHarness<ByteStream>
 {
 public:
-  ByteStreamTestHarness( std::string test_name, uint64_t capacity )
-    : TestHarness( move( test_name ), "capacity=" + std::to_string( capacity ), ByteStream { capacity } )
+  ByteStreamTestHarness( std::string test_name,
+                         uint64_t capacity,
+                         ByteStream::Storage storage = ByteStream::Storage::Ring )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity )
+                     + ( storage == ByteStream::Storage::Chunked ? " (chunked)" : "" ),
+                   ByteStream { capacity, storage } )
   {}
 
   size_t peek_size() { return object().reader().peek().size(); }
@@ -34,6 +39,54 @@ struct Push : public Action<ByteStream>
   constexpr std::string obj() const override { return "Writer"; }
 };
 
+struct ReserveAndCommit : public Action<ByteStream>
+{
+  std::string data_;
+
+  explicit ReserveAndCommit( std::string data ) : data_( move( data ) ) {}
+  std::string description() const override
+  {
+    return "reserve( " + std::to_string( data_.size() ) + " ), fill with \"" + pretty_print( data_ )
+           + "\" and commit";
+  }
+  void execute( ByteStream& bs ) const override
+  {
+    size_t written = 0;
+    for ( const auto piece : bs.writer().reserve( data_.size() ) ) {
+      if ( piece.empty() ) {
+        throw ExpectationViolation { "reserve() returned an empty piece" };
+      }
+      written += data_.copy( piece.data(), piece.size(), written );
+    }
+    bs.writer().commit( written );
+  }
+  constexpr std::string obj() const override { return "Writer"; }
+};
+
+struct WriteAt : public Action<ByteStream>
+{
+  uint64_t offset_;
+  std::string data_;
+
+  WriteAt( uint64_t offset, std::string data ) : offset_( offset ), data_( move( data ) ) {}
+  std::string description() const override
+  {
+    return "write_at( " + std::to_string( offset_ ) + ", \"" + pretty_print( data_ ) + "\" )";
+  }
+  void execute( ByteStream& bs ) const override { bs.writer().write_at( offset_, data_ ); }
+  constexpr std::string obj() const override { return "Writer"; }
+};
+
+struct Advance : public Action<ByteStream>
+{
+  uint64_t len_;
+
+  explicit Advance( uint64_t len ) : len_( len ) {}
+  std::string description() const override { return "advance( " + std::to_string( len_ ) + " )"; }
+  void execute( ByteStream& bs ) const override { bs.writer().advance( len_ ); }
+  constexpr std::string obj() const override { return "Writer"; }
+};
+
 struct Close : public Action<ByteStream>
 {
   std::string description() const override { return "close"; }
@@ -119,6 +172,31 @@ struct PeekOnce : public Peek
   }
 };
 
+struct PeekAll : public Peek
+{
+  using Peek::Peek;
+
+  std::string description() const override
+  {
+    return "peek_all() gives \"" + pretty_print( output_ ) + "\" in total";
+  }
+
+  void execute( const ByteStream& bs ) const override
+  {
+    std::string got;
+    for ( const auto piece : bs.reader().peek_all() ) {
+      if ( piece.empty() ) {
+        throw ExpectationViolation { "peek_all() returned an empty piece" };
+      }
+      got += piece;
+    }
+    if ( got != output_ ) {
+      throw ExpectationViolation { "peek_all() should have returned \"" + pretty_print( output_ )
+                                   + "\", but instead returned \"" + pretty_print( got ) + "\"" };
+    }
+  }
+};
+
 struct IsClosed : public ExpectBool<ByteStream>
 {
   using ExpectBool::ExpectBool;
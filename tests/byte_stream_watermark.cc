@@ -0,0 +1,90 @@
+#include "byte_stream.hh"
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+void expect_events( const string& description, const vector<bool>& actual, const vector<bool>& expected )
+{
+  if ( actual != expected ) {
+    string message = description + ": expected callbacks [";
+    for ( const bool state : expected ) {
+      message += state ? " true" : " false";
+    }
+    message += " ] but got [";
+    for ( const bool state : actual ) {
+      message += state ? " true" : " false";
+    }
+    throw runtime_error( message + " ]" );
+  }
+}
+
+void readable_test( ByteStream::Storage storage )
+{
+  ByteStream stream { 10, storage };
+  vector<bool> events;
+  stream.reader().set_readable_watermark( 3, [&events]( bool readable ) { events.push_back( readable ); } );
+  expect_events( "readable at registration", events, { false } );
+
+  stream.writer().push( "ab" );
+  expect_events( "readable below low watermark", events, { false } );
+
+  stream.writer().push( "c" );
+  stream.writer().push( "d" );
+  expect_events( "readable reaching low watermark", events, { false, true } );
+
+  stream.reader().pop( 2 );
+  expect_events( "readable dropping below low watermark", events, { false, true, false } );
+
+  stream.writer().close();
+  expect_events( "readable on close", events, { false, true, false, true } );
+
+  stream.reader().pop( 2 );
+  expect_events( "readable once finished", events, { false, true, false, true } );
+}
+
+void writable_test( ByteStream::Storage storage )
+{
+  ByteStream stream { 10, storage };
+  vector<bool> events;
+  stream.writer().set_writable_watermark( 4, [&events]( bool writable ) { events.push_back( writable ); } );
+  expect_events( "writable at registration", events, { true } );
+
+  stream.writer().push( "hello" );
+  stream.writer().push( "w" );
+  expect_events( "writable with room left", events, { true } );
+
+  stream.writer().push( "o" );
+  expect_events( "writable filling past high watermark", events, { true, false } );
+
+  stream.reader().pop( 1 );
+  expect_events( "writable draining to high watermark", events, { true, false, true } );
+
+  stream.reader().pop( 2 );
+  expect_events( "writable above high watermark", events, { true, false, true } );
+
+  stream.writer().reserve( 4 );
+  stream.writer().commit( 4 );
+  expect_events( "writable after commit", events, { true, false, true, false } );
+}
+} // namespace
+
+int main()
+{
+  try {
+    for ( const auto storage : { ByteStream::Storage::Ring, ByteStream::Storage::Chunked } ) {
+      readable_test( storage );
+      writable_test( storage );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
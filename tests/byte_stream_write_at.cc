@@ -0,0 +1,85 @@
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <functional>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+void expect_throw( const string& description, const function<void()>& f )
+{
+  try {
+    f();
+  } catch ( const runtime_error& ) {
+    return;
+  }
+  throw runtime_error( description + ": expected an exception" );
+}
+} // namespace
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "write_at is not readable until advance", 15 };
+      test.execute( WriteAt { 3, "def" } );
+      test.execute( BytesBuffered { 0 } );
+      test.execute( AvailableCapacity { 15 } );
+      test.execute( WriteAt { 0, "abc" } );
+      test.execute( Advance { 6 } );
+      test.execute( BytesPushed { 6 } );
+      test.execute( AvailableCapacity { 9 } );
+      test.execute( Peek { "abcdef" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "write_at across the wrap point", 4 };
+      test.execute( Push { "cat" } );
+      test.execute( Pop { 3 } );
+      test.execute( WriteAt { 2, "os" } );
+      test.execute( WriteAt { 0, "ta" } );
+      test.execute( Advance { 4 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( PeekAll { "taos" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "push in front of staged bytes", 15 };
+      test.execute( WriteAt { 3, "def" } );
+      test.execute( Push { "abc" } );
+      test.execute( BytesBuffered { 3 } );
+      test.execute( Advance { 3 } );
+      test.execute( Peek { "abcdef" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "staged bytes survive draining the stream", 8 };
+      test.execute( Push { "ab" } );
+      test.execute( WriteAt { 1, "d" } );
+      test.execute( Pop { 2 } );
+      test.execute( BytesBuffered { 0 } );
+      test.execute( WriteAt { 0, "c" } );
+      test.execute( Advance { 2 } );
+      test.execute( Peek { "cd" } );
+      test.execute( Pop { 2 } );
+      test.execute( ReserveAndCommit { "efgh" } );
+      test.execute( PeekAll { "efgh" } );
+    }
+
+    {
+      ByteStream stream { 4 };
+      expect_throw( "write_at past the available capacity", [&] { stream.writer().write_at( 2, "cde" ); } );
+      stream.writer().write_at( 0, "ab" );
+      expect_throw( "advance past the staged bytes", [&] { stream.writer().advance( 3 ); } );
+
+      ByteStream chunked { 4, ByteStream::Storage::Chunked };
+      expect_throw( "write_at on chunked storage", [&] { chunked.writer().write_at( 0, "ab" ); } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
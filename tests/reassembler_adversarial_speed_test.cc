@@ -0,0 +1,285 @@
+#include "buffer_pool.hh"
+#include "reassembler.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <sys/resource.h>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// Adversarial arrival orders for the Reassembler.
+//
+// Each scenario cuts the stream into capacity-sized windows and delivers the segments of a window in a
+// hostile order before moving on to the next, draining the output after every insert:
+//
+//   random     a random permutation of the window's segments
+//   reverse    the window's segments last-to-first, so nothing is deliverable until the final insert
+//   tiny       1-byte fragments in a random order (worst case for per-insert overhead)
+//   duplicate  every segment of the window delivered `copies` times, shuffled together
+//   holes      every other segment first, then the gaps between them, so each late segment joins two others
+//
+// With no arguments the whole suite runs at a small and a multi-MB capacity, on both kinds of output
+// storage. Results go to stdout as CSV (one row per run, header first) or, with --format json, as one JSON
+// object per line; a human-readable summary goes to the terminal.
+//
+// Usage: reassembler_adversarial_speed_test [--scenario NAME|all] [--capacity BYTES] [--segment-size BYTES]
+//                                           [--bytes BYTES] [--copies N] [--storage ring|chunked|all]
+//                                           [--seed N] [--format csv|json]
+
+namespace {
+
+struct Options
+{
+  string scenario { "all" };
+  vector<size_t> capacities { 65536, 4194304 };
+  size_t segment_size { 1000 };
+  size_t bytes { 4000000 };
+  size_t copies { 8 };
+  string storage { "all" };
+  size_t seed { 2718 };
+  string format { "csv" };
+};
+
+struct Result
+{
+  size_t inserts {};
+  double seconds {};
+  uint64_t peak_pending {}; // most bytes held inside the Reassembler at once
+  uint64_t peak_pool {};    // BufferPool high-water mark during the run (ring storage; chunked keeps the payloads)
+  long max_rss_kib {};      // process-wide high-water mark of resident memory
+};
+
+using SegmentList = vector<tuple<uint64_t, string, bool>>;
+
+string random_data( size_t len, size_t random_seed )
+{
+  default_random_engine rd { random_seed };
+  uniform_int_distribution<char> ud;
+  string ret;
+  ret.reserve( len );
+  for ( size_t i = 0; i < len; ++i ) {
+    ret += ud( rd );
+  }
+  return ret;
+}
+
+// Cut the stream into windows of `capacity` bytes, and each window into segments of `segment_size`, handing each
+// window's segments to `order` to be rearranged.
+SegmentList make_segments( const string& data, size_t capacity, size_t segment_size, auto&& order )
+{
+  SegmentList segments;
+  for ( size_t window = 0; window < data.size(); window += capacity ) {
+    SegmentList window_segments;
+    for ( size_t i = window; i < min( window + capacity, data.size() ); i += segment_size ) {
+      const size_t len = min( { segment_size, window + capacity - i, data.size() - i } );
+      window_segments.emplace_back( i, data.substr( i, len ), i + len == data.size() );
+    }
+    order( window_segments );
+    ranges::move( window_segments, back_inserter( segments ) );
+  }
+  return segments;
+}
+
+SegmentList scenario_segments( const string& scenario, const string& data, const Options& options, size_t capacity )
+{
+  default_random_engine rd { options.seed };
+
+  const auto shuffled = [&]( SegmentList& w ) { ranges::shuffle( w, rd ); };
+
+  if ( scenario == "random" ) {
+    return make_segments( data, capacity, options.segment_size, shuffled );
+  }
+  if ( scenario == "reverse" ) {
+    return make_segments( data, capacity, options.segment_size, []( SegmentList& w ) { ranges::reverse( w ); } );
+  }
+  if ( scenario == "tiny" ) {
+    return make_segments( data, capacity, 1, shuffled );
+  }
+  if ( scenario == "duplicate" ) {
+    return make_segments( data, capacity, options.segment_size, [&]( SegmentList& w ) {
+      const SegmentList originals = w;
+      for ( size_t copy = 1; copy < options.copies; ++copy ) {
+        w.insert( w.end(), originals.begin(), originals.end() );
+      }
+      ranges::shuffle( w, rd );
+    } );
+  }
+  if ( scenario == "holes" ) {
+    return make_segments( data, capacity, options.segment_size, []( SegmentList& w ) {
+      SegmentList reordered;
+      for ( const size_t parity : { 1, 0 } ) {
+        for ( size_t i = parity; i < w.size(); i += 2 ) {
+          reordered.push_back( move( w[i] ) );
+        }
+      }
+      w = move( reordered );
+    } );
+  }
+  throw runtime_error( "unknown scenario \"" + scenario + "\"" );
+}
+
+Result run( const string& data, SegmentList segments, size_t capacity, ByteStream::Storage storage )
+{
+  Reassembler reassembler { ByteStream { capacity, storage } };
+  string output_data;
+  output_data.reserve( data.size() );
+
+  Result result { .inserts = segments.size() };
+  BufferPool::global().reset_peak();
+
+  const auto start_time = steady_clock::now();
+  for ( auto& [first_index, segment, is_last] : segments ) {
+    reassembler.insert( first_index, move( segment ), is_last );
+    result.peak_pending = max( result.peak_pending, reassembler.count_bytes_pending() );
+    while ( reassembler.reader().bytes_buffered() ) {
+      output_data += reassembler.reader().peek();
+      reassembler.reader().pop( output_data.size() - reassembler.reader().bytes_popped() );
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( not reassembler.reader().is_finished() ) {
+    throw runtime_error( "Reassembler did not close ByteStream when finished" );
+  }
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+
+  rusage usage {};
+  getrusage( RUSAGE_SELF, &usage );
+
+  result.seconds = duration_cast<duration<double>>( stop_time - start_time ).count();
+  result.peak_pool = BufferPool::global().stats().peak_bytes_in_use;
+  result.max_rss_kib = usage.ru_maxrss;
+  return result;
+}
+
+size_t parse_size( const string& name, const string& value )
+{
+  size_t pos = 0;
+  const size_t ret = stoull( value, &pos );
+  if ( pos != value.size() or ret == 0 ) {
+    throw runtime_error( "invalid value \"" + value + "\" for " + name );
+  }
+  return ret;
+}
+
+Options parse_options( int argc, char* argv[] ) // NOLINT(*-avoid-c-arrays)
+{
+  Options options;
+  const vector<string> args( argv + 1, argv + argc ); // NOLINT(*-pointer-arithmetic)
+  for ( size_t i = 0; i < args.size(); i += 2 ) {
+    if ( i + 1 == args.size() ) {
+      throw runtime_error( "missing value for " + args[i] );
+    }
+    const string& name = args[i];
+    const string& value = args[i + 1];
+    if ( name == "--scenario" ) {
+      options.scenario = value;
+    } else if ( name == "--capacity" ) {
+      options.capacities = { parse_size( name, value ) };
+    } else if ( name == "--segment-size" ) {
+      options.segment_size = parse_size( name, value );
+    } else if ( name == "--bytes" ) {
+      options.bytes = parse_size( name, value );
+    } else if ( name == "--copies" ) {
+      options.copies = parse_size( name, value );
+    } else if ( name == "--storage" and ( value == "ring" or value == "chunked" or value == "all" ) ) {
+      options.storage = value;
+    } else if ( name == "--seed" ) {
+      options.seed = parse_size( name, value );
+    } else if ( name == "--format" and ( value == "csv" or value == "json" ) ) {
+      options.format = value;
+    } else {
+      throw runtime_error( "unrecognized option " + name + " " + value );
+    }
+  }
+  return options;
+}
+
+void program_body( const Options& options )
+{
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  const vector<string> scenarios = options.scenario == "all"
+                                     ? vector<string> { "random", "reverse", "tiny", "duplicate", "holes" }
+                                     : vector<string> { options.scenario };
+  vector<ByteStream::Storage> storages;
+  if ( options.storage != "chunked" ) {
+    storages.push_back( ByteStream::Storage::Ring );
+  }
+  if ( options.storage != "ring" ) {
+    storages.push_back( ByteStream::Storage::Chunked );
+  }
+
+  const string data = random_data( options.bytes, options.seed );
+
+  if ( options.format == "csv" ) {
+    cout << "scenario,storage,capacity,segment_size,bytes,inserts,ns_per_insert,gbit_per_s,peak_pending_bytes,"
+            "peak_pool_bytes,max_rss_kib\n";
+  }
+
+  for ( const size_t capacity : options.capacities ) {
+    for ( const auto& scenario : scenarios ) {
+      // 1-byte fragments cost one insert per byte, so that scenario moves a tenth of the data
+      const string scenario_data = scenario == "tiny" ? data.substr( 0, data.size() / 10 ) : data;
+      const size_t segment_size = scenario == "tiny" ? 1 : options.segment_size;
+      const SegmentList segments = scenario_segments( scenario, scenario_data, options, capacity );
+
+      for ( const auto storage : storages ) {
+        const Result r = run( scenario_data, segments, capacity, storage );
+        const string storage_name = storage == ByteStream::Storage::Ring ? "ring" : "chunked";
+        const double ns_per_insert = r.seconds * 1e9 / static_cast<double>( r.inserts );
+        const double gigabits_per_second = 8 * static_cast<double>( scenario_data.size() ) / r.seconds / 1e9;
+
+        if ( options.format == "csv" ) {
+          cout << scenario << "," << storage_name << "," << capacity << "," << segment_size << ","
+               << scenario_data.size() << "," << r.inserts << "," << fixed << setprecision( 2 ) << ns_per_insert
+               << "," << gigabits_per_second << "," << r.peak_pending << "," << r.peak_pool << ","
+               << r.max_rss_kib << "\n";
+        } else {
+          cout << R"({"scenario":")" << scenario << R"(","storage":")" << storage_name
+               << R"(","capacity":)" << capacity << R"(,"segment_size":)" << segment_size << R"(,"bytes":)"
+               << scenario_data.size() << R"(,"inserts":)" << r.inserts << R"(,"ns_per_insert":)" << fixed
+               << setprecision( 2 ) << ns_per_insert << R"(,"gbit_per_s":)" << gigabits_per_second
+               << R"(,"peak_pending_bytes":)" << r.peak_pending << R"(,"peak_pool_bytes":)" << r.peak_pool
+               << R"(,"max_rss_kib":)" << r.max_rss_kib << "}\n";
+        }
+
+        debug_output << "        Reassembler " << left << setw( 9 ) << scenario << " " << setw( 7 ) << storage_name
+                     << " capacity " << right << setw( 7 ) << capacity << ": " << fixed << setprecision( 2 )
+                     << setw( 8 ) << ns_per_insert << " ns/insert, " << setw( 6 ) << gigabits_per_second
+                     << " Gbit/s, peak " << r.peak_pending << " bytes pending\n";
+
+        // A loose bound: anything slower points at per-insert work that grows with the number of stored segments
+        if ( ns_per_insert > 50000 ) {
+          throw runtime_error( "Reassembler took more than 50 us per insert in the " + scenario + " scenario." );
+        }
+      }
+    }
+  }
+}
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  try {
+    program_body( parse_options( argc, argv ) );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
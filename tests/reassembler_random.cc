@@ -0,0 +1,160 @@
+#include "reassembler.hh"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+// Insert random (overlapping, out-of-order, partly out-of-window) substrings of a random stream, reading a
+// random amount after each insert, and check the Reassembler against a byte-by-byte model after every step.
+// With max_batch > 1, the substrings go in through insert_batch() in batches of up to that many.
+void random_test( const size_t stream_len, // NOLINT(bugprone-easily-swappable-parameters)
+                  const size_t capacity,   // NOLINT(bugprone-easily-swappable-parameters)
+                  const size_t max_segment,
+                  const size_t random_seed,
+                  const ByteStream::Storage storage,
+                  const size_t max_batch = 1 )
+{
+  default_random_engine rd { random_seed };
+  const string data = [&] {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < stream_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  Reassembler reassembler { ByteStream { capacity, storage } };
+  vector<bool> known( stream_len );
+  size_t model_pushed {};
+  uint64_t model_pending {};
+  string output;
+
+  const string test_name = "stream_len=" + to_string( stream_len ) + " capacity=" + to_string( capacity )
+                           + ( storage == ByteStream::Storage::Chunked ? " (chunked)" : "" )
+                           + ( max_batch > 1 ? " batch=" + to_string( max_batch ) : "" ) + ": ";
+
+  uniform_int_distribution<size_t> start_dist { 0, stream_len - 1 };
+  uniform_int_distribution<size_t> len_dist { 0, max_segment };
+  uniform_int_distribution<size_t> batch_dist { 1, max_batch };
+  while ( not reassembler.reader().is_finished() ) {
+    vector<Reassembler::Segment> batch( batch_dist( rd ) );
+    for ( auto& [first_index, segment, is_last] : batch ) {
+      // Mostly segments around the window (some reaching back over the first unassembled byte, so that the
+      // stream makes progress), and now and then one from anywhere in the stream.
+      first_index = start_dist( rd );
+      switch ( rd() % 4 ) {
+        case 0:
+          first_index = model_pushed - min( model_pushed, first_index % ( max_segment + 1 ) );
+          break;
+        case 1:
+        case 2:
+          first_index = min( stream_len - 1, model_pushed + first_index % ( 2 * capacity ) );
+          break;
+        default:
+          break;
+      }
+      const size_t len = min( len_dist( rd ), stream_len - first_index );
+      segment = data.substr( first_index, len );
+      is_last = len > 0 and first_index + len == stream_len;
+
+      const size_t first_unacceptable = min( stream_len, reassembler.reader().bytes_popped() + capacity );
+      for ( size_t i = max<size_t>( first_index, model_pushed ); i < min( first_index + len, first_unacceptable );
+            ++i ) {
+        model_pending += not known[i];
+        known[i] = true;
+      }
+    }
+    while ( model_pushed < stream_len and known[model_pushed] ) {
+      ++model_pushed;
+      --model_pending;
+    }
+
+    if ( max_batch > 1 ) {
+      reassembler.insert_batch( batch );
+    } else {
+      reassembler.insert( batch[0].first_index, move( batch[0].data ), batch[0].is_last_substring );
+    }
+
+    if ( reassembler.writer().bytes_pushed() != model_pushed ) {
+      throw runtime_error( test_name + "expected " + to_string( model_pushed ) + " bytes pushed, got "
+                           + to_string( reassembler.writer().bytes_pushed() ) );
+    }
+    if ( reassembler.count_bytes_pending() != model_pending ) {
+      throw runtime_error( test_name + "expected " + to_string( model_pending ) + " bytes pending, got "
+                           + to_string( reassembler.count_bytes_pending() ) );
+    }
+
+    // The first few runs of held bytes, as loss recovery (e.g. SACK) would ask for them
+    constexpr size_t max_ranges = 4;
+    vector<Reassembler::Range> model_ranges;
+    uint64_t accounted {};
+    for ( size_t i = model_pushed; accounted < model_pending; ++i ) {
+      if ( not known[i] ) {
+        continue;
+      }
+      if ( model_ranges.empty() or model_ranges.back().first_index + model_ranges.back().length != i ) {
+        if ( model_ranges.size() == max_ranges ) {
+          break;
+        }
+        model_ranges.push_back( { i, 0 } );
+      }
+      ++model_ranges.back().length;
+      ++accounted;
+    }
+    if ( reassembler.received_ranges( max_ranges ) != model_ranges ) {
+      throw runtime_error( test_name + "received_ranges() does not match the bytes held" );
+    }
+    for ( const auto& range : model_ranges ) {
+      const uint64_t last = range.first_index + range.length - 1;
+      if ( reassembler.received_range_at( range.first_index ) != range
+           or reassembler.received_range_at( last ) != range
+           or reassembler.received_range_at( range.first_index - 1 ).has_value() ) {
+        throw runtime_error( test_name + "received_range_at() does not match the bytes held" );
+      }
+    }
+
+    uniform_int_distribution<size_t> pop_dist { 0, reassembler.reader().bytes_buffered() };
+    size_t to_read = pop_dist( rd );
+    while ( to_read > 0 ) {
+      const auto peeked = reassembler.reader().peek().substr( 0, to_read );
+      output += peeked;
+      to_read -= peeked.size();
+      reassembler.reader().pop( peeked.size() );
+    }
+    if ( output != string_view { data }.substr( 0, output.size() ) ) {
+      throw runtime_error( test_name + "reassembled bytes do not match the stream" );
+    }
+  }
+
+  if ( output != data ) {
+    throw runtime_error( test_name + "stream finished early" );
+  }
+}
+} // namespace
+
+int main()
+{
+  try {
+    for ( const auto storage : { ByteStream::Storage::Ring, ByteStream::Storage::Chunked } ) {
+      random_test( 100, 1, 3, 1234, storage );
+      random_test( 1000, 17, 40, 2345, storage );
+      random_test( 20000, 1000, 300, 3456, storage );
+      random_test( 60000, 20000, 1500, 4567, storage );
+      random_test( 1000, 17, 40, 5678, storage, 8 );
+      random_test( 60000, 20000, 1500, 6789, storage, 64 );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
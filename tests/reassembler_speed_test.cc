@@ -8,6 +8,7 @@
 #include <queue>
 #include <random>
 #include <tuple>
+#include <vector>
 
 using namespace std;
 using namespace std::chrono;
@@ -17,7 +18,8 @@ void speed_test( const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-p
                  const size_t overlap,     // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
                  const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
-                 string_view scenario )
+                 string_view scenario,
+                 const ByteStream::Storage storage = ByteStream::Storage::Ring )
 {
   // Generate the data to be written
   const string data = [&] {
@@ -46,7 +48,7 @@ void speed_test( const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-p
     }
   }
 
-  Reassembler reassembler { ByteStream { capacity } };
+  Reassembler reassembler { ByteStream { capacity, storage } };
 
   string output_data;
   output_data.reserve( data.size() );
@@ -81,8 +83,159 @@ void speed_test( const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-p
   fstream debug_output;
   debug_output.open( "/dev/tty" );
 
-  cout << "Reassembler to ByteStream with capacity=" << capacity << " reached " << fixed << setprecision( 2 )
-       << gigabits_per_second << " Gbit/s.\n";
+  const string_view storage_s = storage == ByteStream::Storage::Chunked ? " (chunked)" : "";
+  cout << "Reassembler to ByteStream" << storage_s << " with capacity=" << capacity << " reached " << fixed
+       << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
+
+  debug_output << "        Reassembler throughput " << scenario << fixed << setprecision( 2 ) << setw( 5 )
+               << gigabits_per_second << " Gbit/s\n";
+
+  if ( gigabits_per_second < 0.1 ) {
+    throw runtime_error( "Reassembler did not meet minimum speed of 0.1 Gbit/s." );
+  }
+}
+
+// Heavy reordering: cut each capacity-sized window of the stream into segments and insert them in a random order.
+void reorder_speed_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable-parameters)
+                         const size_t segment_size, // NOLINT(bugprone-easily-swappable-parameters)
+                         const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
+                         const size_t random_seed,  // NOLINT(bugprone-easily-swappable-parameters)
+                         string_view scenario,
+                         const ByteStream::Storage storage = ByteStream::Storage::Ring )
+{
+  default_random_engine rd { random_seed };
+  const string data = [&] {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  vector<tuple<uint64_t, string, bool>> segments;
+  for ( size_t window = 0; window < data.size(); window += capacity ) {
+    const size_t window_start = segments.size();
+    for ( size_t i = window; i < min( window + capacity, data.size() ); i += segment_size ) {
+      const size_t len = min( { segment_size, window + capacity - i, data.size() - i } );
+      segments.emplace_back( i, data.substr( i, len ), i + len == data.size() );
+    }
+    shuffle( segments.begin() + static_cast<ptrdiff_t>( window_start ), segments.end(), rd );
+  }
+
+  Reassembler reassembler { ByteStream { capacity, storage } };
+  string output_data;
+  output_data.reserve( data.size() );
+
+  const auto start_time = steady_clock::now();
+  for ( auto& [first_index, segment, is_last] : segments ) {
+    reassembler.insert( first_index, move( segment ), is_last );
+    while ( reassembler.reader().bytes_buffered() ) {
+      output_data += reassembler.reader().peek();
+      reassembler.reader().pop( output_data.size() - reassembler.reader().bytes_popped() );
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( not reassembler.reader().is_finished() ) {
+    throw runtime_error( "Reassembler did not close ByteStream when finished" );
+  }
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+
+  const auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  const auto gigabits_per_second = 8 * static_cast<double>( input_len ) / test_duration.count() / 1e9;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  const string_view storage_s = storage == ByteStream::Storage::Chunked ? " (chunked)" : "";
+  cout << "Reassembler to ByteStream" << storage_s << " with capacity=" << capacity << ", " << segment_size
+       << "-byte segments shuffled within each window reached " << fixed << setprecision( 2 ) << gigabits_per_second
+       << " Gbit/s.\n";
+
+  debug_output << "        Reassembler throughput " << scenario << fixed << setprecision( 2 ) << setw( 5 )
+               << gigabits_per_second << " Gbit/s\n";
+
+  if ( gigabits_per_second < 0.1 ) {
+    throw runtime_error( "Reassembler did not meet minimum speed of 0.1 Gbit/s." );
+  }
+}
+
+// Bursts: the stream arrives in batches of `batch_size` consecutive segments (in order, or shuffled within the
+// batch), as from one wakeup of the event loop, and is read after each batch. With `use_batch`, each burst
+// goes in through a single insert_batch() call; otherwise through one insert() per segment.
+void batch_speed_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable-parameters)
+                       const size_t segment_size, // NOLINT(bugprone-easily-swappable-parameters)
+                       const size_t batch_size,   // NOLINT(bugprone-easily-swappable-parameters)
+                       const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
+                       const bool shuffled,
+                       const bool use_batch,
+                       string_view scenario )
+{
+  default_random_engine rd { input_len + batch_size };
+  const string data = [&] {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  vector<vector<Reassembler::Segment>> batches;
+  for ( size_t i = 0; i < data.size(); i += segment_size ) {
+    if ( batches.empty() or batches.back().size() == batch_size ) {
+      batches.emplace_back();
+    }
+    const size_t len = min( segment_size, data.size() - i );
+    batches.back().push_back( { i, data.substr( i, len ), i + len == data.size() } );
+  }
+  if ( shuffled ) {
+    for ( auto& batch : batches ) {
+      shuffle( batch.begin(), batch.end(), rd );
+    }
+  }
+
+  Reassembler reassembler { ByteStream { capacity } };
+  string output_data;
+  output_data.reserve( data.size() );
+
+  const auto start_time = steady_clock::now();
+  for ( auto& batch : batches ) {
+    if ( use_batch ) {
+      reassembler.insert_batch( batch );
+    } else {
+      for ( auto& [first_index, segment, is_last] : batch ) {
+        reassembler.insert( first_index, move( segment ), is_last );
+      }
+    }
+    while ( reassembler.reader().bytes_buffered() ) {
+      output_data += reassembler.reader().peek();
+      reassembler.reader().pop( output_data.size() - reassembler.reader().bytes_popped() );
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( not reassembler.reader().is_finished() ) {
+    throw runtime_error( "Reassembler did not close ByteStream when finished" );
+  }
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+
+  const auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  const auto gigabits_per_second = 8 * static_cast<double>( input_len ) / test_duration.count() / 1e9;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "Reassembler with capacity=" << capacity << ", " << batch_size << "-segment bursts"
+       << ( shuffled ? " (shuffled)" : "" ) << ( use_batch ? " via insert_batch" : " via insert" ) << " reached "
+       << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
 
   debug_output << "        Reassembler throughput " << scenario << fixed << setprecision( 2 ) << setw( 5 )
                << gigabits_per_second << " Gbit/s\n";
@@ -96,6 +249,21 @@ void program_body()
 {
   speed_test( 1000, 1500, 1500, 32768, 1370, "(no overlap):  " );
   speed_test( 1000, 1500, 150, 32768, 6163, "(10x overlap): " );
+  reorder_speed_test( 1e7, 1000, 32768, 2718, "(shuffled, 1000-byte segments): " );
+  reorder_speed_test( 1e7, 100, 32768, 2818, "(shuffled, 100-byte segments):  " );
+  reorder_speed_test( 1e7, 1000, 1048576, 2918, "(shuffled, 1 MiB window):       " );
+
+  // Chunked output: payloads are kept as slices and moved into the stream
+  constexpr auto chunked = ByteStream::Storage::Chunked;
+  speed_test( 1000, 1500, 1500, 32768, 1370, "(no overlap, chunked):  ", chunked );
+  speed_test( 1000, 1500, 150, 32768, 6163, "(10x overlap, chunked): ", chunked );
+  reorder_speed_test( 1e7, 1000, 32768, 2718, "(shuffled, 1000-byte segments, chunked): ", chunked );
+
+  // 64-segment bursts, one insert() per segment against one insert_batch() per burst
+  batch_speed_test( 1e7, 1000, 64, 65536, false, false, "(64-segment bursts, insert):                " );
+  batch_speed_test( 1e7, 1000, 64, 65536, false, true, "(64-segment bursts, insert_batch):          " );
+  batch_speed_test( 1e7, 1000, 64, 65536, true, false, "(64-segment shuffled bursts, insert):       " );
+  batch_speed_test( 1e7, 1000, 64, 65536, true, true, "(64-segment shuffled bursts, insert_batch): " );
 }
 
 int main()
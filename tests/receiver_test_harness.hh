@@ -4,9 +4,11 @@
 #include "tcp_receiver.hh"
 #include "tcp_receiver_message.hh"
 
+#include <algorithm>
 #include <optional>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 template<std::derived_from<TestStep<Reassembler>> T>
 struct DirectReassemblerTest : public TestStep<TCPReceiver>
@@ -37,10 +39,10 @@ struct DirectByteStreamTest : public TestStep<TCPReceiver>
 class TCPReceiverTestHarness : public TestHarness<TCPReceiver>
 {
 public:
-  TCPReceiverTestHarness( std::string test_name, uint64_t capacity )
+  TCPReceiverTestHarness( std::string test_name, uint64_t capacity, bool send_sack = false )
     : TestHarness( move( test_name ),
-                   "capacity=" + std::to_string( capacity ),
-                   { TCPReceiver { Reassembler { ByteStream { capacity } } } } )
+                   "capacity=" + std::to_string( capacity ) + ( send_sack ? " with SACK" : "" ),
+                   { TCPReceiver { Reassembler { ByteStream { capacity } }, send_sack } } )
   {}
 
   template<std::derived_from<TestStep<Reassembler>> T>
@@ -108,6 +110,33 @@ struct ExpectAcknoBetween : public Expectation<TCPReceiver>
   }
 };
 
+struct ExpectSack : public Expectation<TCPReceiver>
+{
+  std::vector<TCPReceiverMessage::SackBlock> blocks_;
+
+  explicit ExpectSack( std::vector<TCPReceiverMessage::SackBlock> blocks ) : blocks_( std::move( blocks ) ) {}
+
+  static std::string describe( const std::vector<TCPReceiverMessage::SackBlock>& blocks )
+  {
+    std::string ret = "[";
+    for ( const auto& block : blocks ) {
+      ret += " " + to_string( block.left ) + "-" + to_string( block.right );
+    }
+    return ret + " ]";
+  }
+
+  std::string description() const override { return "SACK blocks are " + describe( blocks_ ); }
+
+  void execute( const TCPReceiver& rs ) const override
+  {
+    const auto actual = rs.send().sack;
+    const auto same = []( const auto& a, const auto& b ) { return a.left == b.left and a.right == b.right; };
+    if ( not std::ranges::equal( actual, blocks_, same ) ) {
+      throw ExpectationViolation( "SACK blocks were " + describe( actual ) + ", expected " + describe( blocks_ ) );
+    }
+  }
+};
+
 struct HasAckno : public ExpectBool<TCPReceiver>
 {
   using ExpectBool::ExpectBool;
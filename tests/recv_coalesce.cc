@@ -0,0 +1,110 @@
+#include "tcp_coalescer.hh"
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+TCPMessage data_segment( uint32_t seqno, string payload, uint32_t ackno = 1000, uint16_t window = 5000 )
+{
+  return { TCPSenderMessage { .seqno = Wrap32 { seqno }, .payload = move( payload ) },
+           TCPReceiverMessage { .ackno = Wrap32 { ackno }, .window_size = window } };
+}
+
+void expect_payloads( const string& description,
+                      const vector<TCPMessage>& messages,
+                      const vector<string>& expected )
+{
+  vector<string> actual;
+  actual.reserve( messages.size() );
+  for ( const auto& message : messages ) {
+    actual.push_back( message.sender->payload );
+  }
+  if ( actual != expected ) {
+    string message = description + ": expected payloads [";
+    for ( const auto& payload : expected ) {
+      message += " \"" + payload + "\"";
+    }
+    message += " ] but got [";
+    for ( const auto& payload : actual ) {
+      message += " \"" + payload + "\"";
+    }
+    throw runtime_error( message + " ]" );
+  }
+}
+} // namespace
+
+int main()
+{
+  try {
+    {
+      vector<TCPMessage> messages;
+      messages.push_back( data_segment( 10, "abc" ) );
+      messages.push_back( data_segment( 13, "def" ) );
+      messages.push_back( data_segment( 16, "gh", 1000, 4000 ) );
+      coalesce_segments( messages );
+      expect_payloads( "consecutive segments", messages, { "abcdefgh" } );
+      if ( messages[0].sender->seqno != Wrap32 { 10 } or messages[0].receiver->window_size != 4000 ) {
+        throw runtime_error( "merged segment should keep the first seqno and the last window" );
+      }
+    }
+
+    {
+      vector<TCPMessage> messages;
+      messages.push_back( data_segment( 10, "abc" ) );
+      messages.push_back( data_segment( 20, "xyz" ) ); // a gap
+      messages.push_back( data_segment( 23, "uvw" ) );
+      messages.push_back( data_segment( 26, "rst", 1001 ) ); // a new ackno
+      coalesce_segments( messages );
+      expect_payloads( "gaps and ackno changes split runs", messages, { "abc", "xyzuvw", "rst" } );
+    }
+
+    {
+      vector<TCPMessage> messages;
+      messages.push_back( data_segment( 10, "abc" ) );
+      messages.push_back( data_segment( 13, "" ) ); // a bare ACK
+      messages.push_back( data_segment( 13, "def" ) );
+      coalesce_segments( messages );
+      expect_payloads( "bare ACKs are kept", messages, { "abc", "", "def" } );
+    }
+
+    {
+      vector<TCPMessage> messages;
+      messages.push_back( data_segment( 10, "abc" ) );
+      messages.push_back( data_segment( 13, "def" ) );
+      messages.back().sender->FIN = true;
+      messages.push_back( data_segment( 17, "ghi" ) );
+      coalesce_segments( messages );
+      expect_payloads( "FIN ends a run", messages, { "abcdef", "ghi" } );
+      if ( not messages[0].sender->FIN ) {
+        throw runtime_error( "merged segment should carry the FIN" );
+      }
+    }
+
+    {
+      vector<TCPMessage> messages;
+      messages.push_back( data_segment( 10, "abc" ) );
+      messages.push_back( data_segment( 13, "def" ) );
+      messages.push_back( data_segment( 16, "ghi" ) );
+      coalesce_segments( messages, 6 );
+      expect_payloads( "payload limit", messages, { "abcdef", "ghi" } );
+    }
+
+    {
+      vector<TCPMessage> messages;
+      messages.push_back( data_segment( UINT32_MAX - 1, "abc" ) );
+      messages.push_back( data_segment( 1, "def" ) );
+      coalesce_segments( messages );
+      expect_payloads( "across the seqno wrap", messages, { "abcdef" } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+#include "byte_stream_test_harness.hh"
+#include "helpers.hh"
+#include "random.hh"
+#include "receiver_test_harness.hh"
+#include "tcp_segment.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "no SACK blocks unless enabled", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSack { {} } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "SACK blocks follow the holes", 4000, true };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectSack { {} } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectSack { { { Wrap32 { isn + 5 }, Wrap32 { isn + 9 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 12 ).with_data( "lm" ) );
+      test.execute( ExpectSack {
+        { { Wrap32 { isn + 12 }, Wrap32 { isn + 14 } }, { Wrap32 { isn + 5 }, Wrap32 { isn + 9 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ij" ) );
+      test.execute( ExpectSack {
+        { { Wrap32 { isn + 5 }, Wrap32 { isn + 11 } }, { Wrap32 { isn + 12 }, Wrap32 { isn + 14 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 11 } } );
+      test.execute( ExpectSack { { { Wrap32 { isn + 12 }, Wrap32 { isn + 14 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 11 ).with_data( "k" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 14 } } );
+      test.execute( ExpectSack { {} } );
+      test.execute( ReadAll { "abcdefghijklm" } );
+    }
+
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "at most four blocks, the most recent first", 4000, true };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      for ( uint32_t i = 1; i <= 7; ++i ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 10 * i ).with_data( "xyz" ) );
+      }
+      vector<TCPReceiverMessage::SackBlock> blocks;
+      for ( uint32_t i = 7; i > 7 - TCPReceiverMessage::MAX_SACK_BLOCKS; --i ) {
+        blocks.push_back( { Wrap32 { isn + 10 * i }, Wrap32 { isn + 10 * i + 3 } } );
+      }
+      test.execute( ExpectSack { blocks } );
+
+      // A retransmission into an older range reports that range first; the rest keep their order
+      test.execute( SegmentArrives {}.with_seqno( isn + 23 ).with_data( "w" ) );
+      blocks.insert( blocks.begin(), { Wrap32 { isn + 20 }, Wrap32 { isn + 24 } } );
+      blocks.pop_back();
+      test.execute( ExpectSack { blocks } );
+
+      // Once that range is acknowledged, the block left over goes to the lowest range still held
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( string( 19, 'a' ) ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 24 } } );
+      blocks.erase( blocks.begin() );
+      blocks.push_back( { Wrap32 { isn + 30 }, Wrap32 { isn + 33 } } );
+      test.execute( ExpectSack { blocks } );
+    }
+
+    {
+      // SACK blocks survive the trip through the TCP header's options
+      TCPSegment seg;
+      seg.message.sender->seqno = Wrap32 { 7 };
+      seg.message.sender->payload = "hello";
+      seg.message.receiver->ackno = Wrap32 { 1000 };
+      seg.message.receiver->window_size = 3000;
+      seg.message.receiver->sack = { { Wrap32 { 1100 }, Wrap32 { 1200 } }, { Wrap32 { 1500 }, Wrap32 { 1600 } } };
+      if ( seg.header_length() != TCPSegment::HEADER_LENGTH + 20 ) {
+        throw runtime_error( "unexpected header length with two SACK blocks" );
+      }
+      seg.compute_checksum( 0 );
+
+      TCPSegment parsed;
+      if ( not parse( parsed, vector<string> { concat( serialize( seg ) ) }, 0 ) ) {
+        throw runtime_error( "segment with SACK blocks did not parse" );
+      }
+      if ( ExpectSack::describe( parsed.message.receiver->sack )
+             != ExpectSack::describe( seg.message.receiver->sack )
+           or parsed.message.sender->payload != "hello" or parsed.message.receiver->ackno != Wrap32 { 1000 } ) {
+        throw runtime_error( "segment with SACK blocks changed in transit: " + parsed.to_string() );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+constexpr uint16_t window = 60000;
+constexpr uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+// Expect `count` full-sized segments, the first starting at `seqno`
+void expect_segments( TCPSenderTestHarness& test, Wrap32 seqno, uint64_t count )
+{
+  for ( uint64_t i = 0; i < count; ++i ) {
+    test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( seqno + i * mss ) );
+  }
+  test.execute( ExpectNoSegment {} );
+}
+
+// Open the connection into a large receive window, and fill the initial congestion window
+void start( TCPSenderTestHarness& test, Wrap32 isn, uint64_t bytes )
+{
+  test.execute( Push {} );
+  test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+  test.execute( Receive { { isn + 1, window } } );
+  test.execute( Push { string( bytes, 'x' ) } );
+  expect_segments( test, isn + 1, 10 );
+}
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "Without congestion control, the receive window is the limit", cfg };
+      test.execute( ExpectCwnd { UINT64_MAX } );
+      test.execute( ExpectSsthresh { UINT64_MAX } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( Receive { { isn + 1, window } } );
+      test.execute( Push { string( 30 * mss, 'x' ) } );
+      expect_segments( test, isn + 1, 30 );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+      TCPSenderTestHarness test { "NewReno slow start, timeout and congestion avoidance", cfg };
+      test.execute( ExpectCwnd { 10 * mss } );
+      start( test, isn, 30 * mss );
+      test.execute( ExpectCwnd { 10 * mss } );
+      test.execute( ExpectSsthresh { UINT64_MAX } );
+
+      // Slow start: the window grows by every byte acknowledged
+      test.execute( Tick { 10 } );
+      test.execute( Receive { { isn + 1 + 10 * mss, window } } );
+      test.execute( ExpectCwnd { 20 * mss } );
+      expect_segments( test, isn + 1 + 10 * mss, 20 );
+
+      // A timeout halves ssthresh (to half the flight) and drops the window to one segment
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 + 10 * mss ) );
+      test.execute( ExpectCwnd { mss } );
+      test.execute( ExpectSsthresh { 10 * mss } );
+
+      // 19 segments are still in flight, more than the window allows
+      test.execute( Receive { { isn + 1 + 11 * mss, window } } );
+      test.execute( ExpectCwnd { 2 * mss } );
+      test.execute( ExpectNoSegment {} );
+
+      // Slow start up to ssthresh, then one segment per window acknowledged
+      test.execute( Receive { { isn + 1 + 30 * mss, window } } );
+      test.execute( ExpectCwnd { 11 * mss } );
+      test.execute( ExpectSsthresh { 10 * mss } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::Cubic;
+
+      TCPSenderTestHarness test { "CUBIC reduction and recovery", cfg };
+      start( test, isn, 20 * mss );
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 ) );
+      test.execute( ExpectCwnd { mss } );
+      test.execute( ExpectSsthresh { 7 * mss } ); // beta * 10 segments
+
+      // Six segments of slow start reach ssthresh; the other four start a congestion-avoidance epoch, where
+      // the cubic (still below the window) gives way to the Reno-friendly estimate
+      test.execute( Receive { { isn + 1 + 10 * mss, window } } );
+      const double w_est = 7 + 3 * ( 1 - Cubic::beta ) / ( 1 + Cubic::beta ) * 4 / 7;
+      const auto cwnd = static_cast<uint64_t>( llround( w_est * mss ) );
+      test.execute( ExpectCwnd { cwnd } );
+      test.execute( ExpectSsthresh { 7 * mss } );
+      for ( uint64_t sent = 0; sent < cwnd; sent += mss ) {
+        const uint64_t len = min( mss, cwnd - sent );
+        test.execute( ExpectMessage {}.with_payload_size( len ).with_seqno( isn + 1 + 10 * mss + sent ) );
+      }
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::BBRLite;
+
+      TCPSenderTestHarness test { "BBR-lite startup and timeout", cfg };
+      start( test, isn, 30 * mss );
+      test.execute( Tick { 10 } );
+      test.execute( Receive { { isn + 1 + 10 * mss, window } } );
+      test.execute( ExpectCwnd { 20 * mss } );
+      test.execute( ExpectSsthresh { UINT64_MAX } );
+      expect_segments( test, isn + 1 + 10 * mss, 20 );
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 + 10 * mss ) );
+      test.execute( ExpectCwnd { mss } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
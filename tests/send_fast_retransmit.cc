@@ -0,0 +1,129 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+constexpr uint16_t window = 60000;
+constexpr uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+void expect_segment( TCPSenderTestHarness& test, Wrap32 seqno )
+{
+  test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( seqno ) );
+}
+
+// Open the connection into a large receive window, and send `segments` full-sized segments
+void start( TCPSenderTestHarness& test, Wrap32 isn, uint64_t bytes, uint64_t segments )
+{
+  test.execute( Push {} );
+  test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+  test.execute( Receive { { isn + 1, window } } );
+  test.execute( Push { string( bytes, 'x' ) } );
+  for ( uint64_t i = 0; i < segments; ++i ) {
+    expect_segment( test, isn + 1 + i * mss );
+  }
+  test.execute( ExpectNoSegment {} );
+}
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+      TCPSenderTestHarness test { "Without fast retransmit, duplicate ACKs are ignored", cfg };
+      start( test, isn, 20 * mss, 10 );
+      for ( int i = 0; i < 5; ++i ) {
+        test.execute( Receive { { isn + 1, window } } );
+        test.execute( ExpectNoSegment {} );
+      }
+      test.execute( ExpectCwnd { 10 * mss } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.fast_retransmit = true;
+
+      TCPSenderTestHarness test { "Fast retransmit without congestion control", cfg };
+      start( test, isn, 3 * mss, 3 );
+      test.execute( Receive { { isn + 1, window } } );
+      test.execute( Receive { { isn + 1, window } } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Receive { { isn + 1, window } } );
+      expect_segment( test, isn + 1 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectConsecutiveRetransmissions { 0 } );
+      test.execute( Receive { { isn + 1, window } } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Receive { { isn + 1 + 3 * mss, window } } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+      cfg.fast_retransmit = true;
+
+      TCPSenderTestHarness test { "NewReno fast recovery with a partial ACK", cfg };
+      start( test, isn, 20 * mss, 10 );
+
+      // Segments 0 and 4 are lost: the other eight arrive, each producing a duplicate ACK
+      test.execute( Receive { { isn + 1, window } } );
+      test.execute( Receive { { isn + 1, window } } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Receive { { isn + 1, window } } );
+      expect_segment( test, isn + 1 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSsthresh { 5 * mss } );
+      test.execute( ExpectCwnd { 5 * mss } );
+
+      // The window is inflated by the three segments that left the network, then one more per duplicate ACK
+      test.execute( Receive { { isn + 1, window } } );
+      test.execute( Receive { { isn + 1, window } } );
+      test.execute( ExpectNoSegment {} );
+      for ( uint64_t i = 10; i < 13; ++i ) {
+        test.execute( Receive { { isn + 1, window } } );
+        expect_segment( test, isn + 1 + i * mss );
+        test.execute( ExpectNoSegment {} );
+      }
+
+      // The retransmission fills the first hole; the ACK stops at the second, which is retransmitted at once.
+      // Deflating by the 4 segments acknowledged (and keeping one) leaves room for one new segment.
+      test.execute( Receive { { isn + 1 + 4 * mss, window } } );
+      expect_segment( test, isn + 1 + 4 * mss );
+      expect_segment( test, isn + 1 + 13 * mss );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCwnd { 5 * mss } );
+
+      // The ACK for everything sent before recovery began ends it, with the window at ssthresh
+      test.execute( Receive { { isn + 1 + 14 * mss, window } } );
+      for ( uint64_t i = 14; i < 19; ++i ) {
+        expect_segment( test, isn + 1 + i * mss );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCwnd { 5 * mss } );
+      test.execute( ExpectSsthresh { 5 * mss } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
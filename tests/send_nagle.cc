@@ -0,0 +1,114 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+constexpr uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+constexpr uint16_t window = 60000;
+
+void connect( TCPSenderTestHarness& test, Wrap32 isn )
+{
+  test.execute( Push {} );
+  test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+  test.execute( Receive { { isn + 1, window } } );
+}
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.nodelay = false;
+
+      TCPSenderTestHarness test { "Nagle's algorithm holds small writes while one is unacknowledged", cfg };
+      connect( test, isn );
+      test.execute( Push { "a" } );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "a" ).with_seqno( isn + 1 ) );
+      test.execute( Push { "b" } );
+      test.execute( Push { "c" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Receive { { isn + 2, window } } );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "bc" ).with_seqno( isn + 2 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // Full segments go out at once; only the short remainder waits
+      test.execute( Push { string( mss + 500, 'x' ) } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 4 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectNoSegment {} );
+
+      // Closing the stream sends the remainder, with the FIN
+      test.execute( Close {} );
+      test.execute( ExpectMessage {}.with_fin( true ).with_payload_size( 500 ).with_seqno( isn + 4 + mss ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.cork = true;
+      cfg.cork_timeout = 100;
+
+      TCPSenderTestHarness test { "The cork holds short segments until full, flushed, or timed out", cfg };
+      connect( test, isn );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 99 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // Writes coalesce into a full segment, which goes out without waiting
+      test.execute( Push { string( mss - 1, 'x' ) } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 50 } );
+      test.execute( Push { "y" } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 4 ) );
+      test.execute( ExpectNoSegment {} );
+
+      // The timer starts over with the next short segment
+      test.execute( Push { "zz" } );
+      test.execute( Tick { 60 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Flush {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "zz" ).with_seqno( isn + 4 + mss ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 100 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+
+      TCPSenderTestHarness test { "By default, small writes go out at once", cfg };
+      connect( test, isn );
+      test.execute( Push { "a" } );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "a" ).with_seqno( isn + 1 ) );
+      test.execute( Push { "b" } );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( "b" ).with_seqno( isn + 2 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
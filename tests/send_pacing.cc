@@ -0,0 +1,110 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+namespace {
+constexpr uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+void expect_segment( TCPSenderTestHarness& test, Wrap32 isn, uint64_t i )
+{
+  test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 + i * mss ) );
+}
+
+// Open the connection, with the SYN's ACK arriving after `rtt_ms` (the first RTT sample, if pacing)
+void connect( TCPSenderTestHarness& test, Wrap32 isn, uint64_t rtt_ms, uint16_t window )
+{
+  test.execute( Push {} );
+  test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+  test.execute( Tick { rtt_ms } );
+  test.execute( Receive { { isn + 1, window } } );
+}
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+      cfg.pacing = true;
+
+      // In slow start: 2 * 10000 bytes / 20 ms = one segment per millisecond
+      TCPSenderTestHarness test { "Pacing spreads the initial window over the RTT", cfg };
+      connect( test, isn, 20, 60000 );
+      test.execute( ExpectSRTT { 20 } );
+      test.execute( ExpectRTO { cfg.rt_timeout } );
+      test.execute( ExpectPacingDelay { nullopt } );
+      test.execute( Push { string( 20 * mss, 'x' ) } );
+      expect_segment( test, isn, 0 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectPacingDelay { 1 } );
+      for ( uint64_t i = 1; i < 10; ++i ) {
+        test.execute( Tick { 1 } );
+        expect_segment( test, isn, i );
+        test.execute( ExpectNoSegment {} );
+      }
+
+      // The congestion window is full: nothing is held back by pacing
+      test.execute( ExpectPacingDelay { nullopt } );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.pacing = true;
+
+      // Without congestion control: 1.2 * 4000 bytes / 10 ms, a segment every 2.08 ms
+      TCPSenderTestHarness test { "Pacing the receive window without congestion control", cfg };
+      connect( test, isn, 10, 4000 );
+      test.execute( ExpectSRTT { 10 } );
+      test.execute( Push { string( 4 * mss, 'x' ) } );
+      expect_segment( test, isn, 0 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectPacingDelay { 2 } );
+      for ( uint64_t i = 1; i < 4; ++i ) {
+        test.execute( Tick { 1 } );
+        test.execute( ExpectNoSegment {} );
+        test.execute( Tick { 1 } );
+        expect_segment( test, isn, i );
+        test.execute( ExpectNoSegment {} );
+      }
+      test.execute( ExpectPacingDelay { nullopt } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+
+      TCPSenderTestHarness test { "Without pacing, the window goes out at once", cfg };
+      connect( test, isn, 20, 60000 );
+      test.execute( Push { string( 10 * mss, 'x' ) } );
+      for ( uint64_t i = 0; i < 10; ++i ) {
+        expect_segment( test, isn, i );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectPacingDelay { nullopt } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
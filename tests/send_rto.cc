@@ -0,0 +1,119 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rt_timeout = 1000;
+      cfg.adaptive_rto = true;
+      cfg.min_rto = 10;
+
+      TCPSenderTestHarness test { "Adaptive RTO follows the measured RTT", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( ExpectRTO { 1000 } );
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      // First sample: SRTT = 20, RTTVAR = 10, RTO = 20 + 4 * 10
+      test.execute( ExpectSRTT { 20 } );
+      test.execute( ExpectRTO { 60 } );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( Tick { 59 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectRTO { 120 } );
+      // An ACK of a retransmitted segment is not timed (Karn's algorithm), but still ends the backoff
+      test.execute( Tick { 5 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      test.execute( ExpectSRTT { 20 } );
+      test.execute( ExpectRTO { 60 } );
+      test.execute( ExpectConsecutiveRetransmissions { 0 } );
+      // Second sample: RTTVAR = 3/4 * 10 + 1/4 * 20, SRTT = 7/8 * 20 + 1/8 * 40, RTO = ceil(22.5 + 4 * 12.5)
+      test.execute( Push { "def" } );
+      test.execute( ExpectMessage {}.with_data( "def" ).with_seqno( isn + 4 ) );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { Wrap32 { isn + 7 } } );
+      test.execute( ExpectSRTT { 22.5 } );
+      test.execute( ExpectRTO { 73 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rt_timeout = 1000;
+      cfg.adaptive_rto = true;
+      cfg.min_rto = 200;
+      cfg.max_rto = 500;
+
+      TCPSenderTestHarness test { "Adaptive RTO stays within min_rto and max_rto", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 2 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSRTT { 2 } );
+      test.execute( ExpectRTO { 200 } );
+      test.execute( Push { "a" } );
+      test.execute( ExpectMessage {}.with_data( "a" ) );
+      test.execute( Tick { 199 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "a" ) );
+      test.execute( ExpectRTO { 400 } );
+      test.execute( Tick { 400 } );
+      test.execute( ExpectMessage {}.with_data( "a" ) );
+      test.execute( ExpectRTO { 500 } );
+      test.execute( Tick { 499 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "a" ) );
+      test.execute( ExpectRTO { 500 } );
+      test.execute( ExpectConsecutiveRetransmissions { 3 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.rt_timeout = 100;
+
+      TCPSenderTestHarness test { "Without adaptive RTO, ACKs reset the RTO to rt_timeout", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 100 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( ExpectRTO { 200 } );
+      test.execute( Tick { 20 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSRTT { 0 } );
+      test.execute( ExpectRTO { 100 } );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 30 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      test.execute( ExpectSRTT { 0 } );
+      test.execute( ExpectRTO { 100 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,176 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+namespace {
+constexpr uint16_t window = 60000;
+constexpr uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+Wrap32 segment_seqno( Wrap32 isn, uint64_t i )
+{
+  return isn + 1 + i * mss;
+}
+
+void expect_segment( TCPSenderTestHarness& test, Wrap32 isn, uint64_t i )
+{
+  test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( segment_seqno( isn, i ) ) );
+}
+
+// Open the connection into a large receive window, and send `segments` full-sized segments
+void start( TCPSenderTestHarness& test, Wrap32 isn, uint64_t bytes, uint64_t segments )
+{
+  test.execute( Push {} );
+  test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+  test.execute( Receive { { isn + 1, window } } );
+  test.execute( Push { string( bytes, 'x' ) } );
+  for ( uint64_t i = 0; i < segments; ++i ) {
+    expect_segment( test, isn, i );
+  }
+  test.execute( ExpectNoSegment {} );
+}
+
+// An ACK for everything before segment `acked`, SACKing segments [first, last)
+Receive ack_with_sack( Wrap32 isn, uint64_t acked, uint64_t first, uint64_t last )
+{
+  return move( Receive { { segment_seqno( isn, acked ), window } }.with_sack( segment_seqno( isn, first ),
+                                                                             segment_seqno( isn, last ) ) );
+}
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+      cfg.sack = true;
+
+      TCPSenderTestHarness test { "SACK recovery retransmits only the holes", cfg };
+      start( test, isn, 20 * mss, 10 );
+
+      // Segments 0 and 4 are lost. A SACKed segment has left the network, so the first two each let a new
+      // segment out; the third starts recovery, retransmitting the first hole.
+      test.execute( ack_with_sack( isn, 0, 1, 2 ) );
+      expect_segment( test, isn, 10 );
+      test.execute( ack_with_sack( isn, 0, 1, 3 ) );
+      expect_segment( test, isn, 11 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ack_with_sack( isn, 0, 1, 4 ) );
+      expect_segment( test, isn, 0 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSsthresh { 6 * mss } );
+      test.execute( ExpectCwnd { 6 * mss } );
+
+      // Segment 4 is lost once three segments after it are SACKed, and retransmitted when the pipe (the
+      // twelve segments sent, less those SACKed or lost) drops below the window. After that, each segment
+      // SACKed lets one new segment out.
+      const auto sack_up_to = [&]( uint64_t last ) {
+        return move( Receive { { segment_seqno( isn, 0 ), window } }
+                       .with_sack( segment_seqno( isn, 1 ), segment_seqno( isn, 4 ) )
+                       .with_sack( segment_seqno( isn, 5 ), segment_seqno( isn, last ) ) );
+      };
+      test.execute( sack_up_to( 6 ) );
+      test.execute( sack_up_to( 7 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( sack_up_to( 8 ) );
+      expect_segment( test, isn, 4 );
+      test.execute( ExpectNoSegment {} );
+      for ( uint64_t i = 9; i <= 12; ++i ) {
+        test.execute( sack_up_to( i ) );
+        expect_segment( test, isn, i + 3 );
+        test.execute( ExpectNoSegment {} );
+      }
+
+      // The first retransmission arrives: a partial ACK, for a hole already retransmitted
+      test.execute( ack_with_sack( isn, 4, 5, 12 ) );
+      expect_segment( test, isn, 16 );
+      test.execute( ExpectNoSegment {} );
+
+      // The second one ends recovery, with the window at ssthresh
+      test.execute( Receive { { segment_seqno( isn, 12 ), window } } );
+      expect_segment( test, isn, 17 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCwnd { 6 * mss } );
+      test.execute( ExpectSeqnosInFlight { 6 * mss } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+      cfg.sack = true;
+
+      TCPSenderTestHarness test { "SACK blocks start recovery without three duplicate ACKs", cfg };
+      start( test, isn, 10 * mss, 10 );
+      test.execute( ack_with_sack( isn, 0, 1, 4 ) );
+      expect_segment( test, isn, 0 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSsthresh { 5 * mss } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.congestion_control = CongestionControl::Algorithm::NewReno;
+      cfg.sack = true;
+
+      // Segments 0 to 2 are lost: all three are resent at once, not one per partial ACK
+      TCPSenderTestHarness test { "SACK recovery resends a burst of losses in one round trip", cfg };
+      start( test, isn, 10 * mss, 10 );
+      test.execute( ack_with_sack( isn, 0, 3, 10 ) );
+      expect_segment( test, isn, 0 );
+      expect_segment( test, isn, 1 );
+      expect_segment( test, isn, 2 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSsthresh { 5 * mss } );
+
+      test.execute( Receive { { segment_seqno( isn, 10 ), window } } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.isn = isn;
+      cfg.sack = true;
+
+      TCPSenderTestHarness test { "After a timeout, SACKed segments are not retransmitted", cfg };
+      start( test, isn, 5 * mss, 5 );
+      test.execute( Receive { { segment_seqno( isn, 0 ), window } }
+                      .with_sack( segment_seqno( isn, 1 ), segment_seqno( isn, 2 ) )
+                      .with_sack( segment_seqno( isn, 3 ), segment_seqno( isn, 4 ) ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { cfg.rt_timeout - 1U } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      expect_segment( test, isn, 0 );
+      test.execute( ExpectNoSegment {} );
+
+      // Everything else not SACKed is presumed lost, and resent once the ACK shows the connection is alive
+      test.execute( ack_with_sack( isn, 2, 3, 4 ) );
+      expect_segment( test, isn, 2 );
+      expect_segment( test, isn, 4 );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Receive { { segment_seqno( isn, 5 ), window } } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// Push a stream through a TCPSender against a receiver that acknowledges everything it is sent: either each
+// segment as it arrives (`acks_per_window` = 0), or the whole window with a few cumulative ACKs.
+void speed_test( const size_t input_len,       // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t capacity,        // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t acks_per_window, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t random_seed,     // NOLINT(bugprone-easily-swappable-parameters)
+                 string_view scenario )
+{
+  const string data = [&] {
+    default_random_engine rd { random_seed };
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  const Wrap32 isn { static_cast<uint32_t>( random_seed ) };
+  TCPSender sender { ByteStream { capacity }, isn, TCPConfig::TIMEOUT_DFLT };
+
+  // What the receiver has seen: the end (in absolute seqnos) of each segment, and how many payload bytes
+  vector<uint64_t> segment_ends;
+  uint64_t received_seqno = 0;
+  size_t bytes_received = 0;
+  const auto transmit = [&]( const TCPSenderMessage& message ) {
+    received_seqno = message.seqno.unwrap( isn, received_seqno ) + message.sequence_length();
+    bytes_received += message.payload.size();
+    segment_ends.push_back( received_seqno );
+  };
+  const auto ack = [&]( uint64_t seqno ) {
+    sender.receive( { Wrap32::wrap( seqno, isn ), UINT16_MAX, false } );
+  };
+
+  size_t written = 0;
+  const auto start_time = steady_clock::now();
+  while ( not as_const( sender ).reader().is_finished() or sender.sequence_numbers_in_flight() ) {
+    const size_t len = min( sender.writer().available_capacity(), data.size() - written );
+    sender.writer().push( data.substr( written, len ) );
+    written += len;
+    if ( written == data.size() and not sender.writer().is_closed() ) {
+      sender.writer().close();
+    }
+
+    segment_ends.clear();
+    sender.push( transmit );
+    if ( segment_ends.empty() ) {
+      throw runtime_error( "TCPSender sent nothing into an open window" );
+    }
+
+    if ( acks_per_window == 0 ) {
+      for ( const uint64_t end : segment_ends ) {
+        ack( end );
+      }
+    } else {
+      const size_t stride = max<size_t>( segment_ends.size() / acks_per_window, 1 );
+      for ( size_t i = stride - 1; i < segment_ends.size(); i += stride ) {
+        ack( segment_ends[i] );
+      }
+      ack( segment_ends.back() );
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( bytes_received != data.size() ) {
+    throw runtime_error( "TCPSender did not send every byte exactly once" );
+  }
+
+  const auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  const auto gigabits_per_second = 8 * static_cast<double>( input_len ) / test_duration.count() / 1e9;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "TCPSender with capacity=" << capacity << ", "
+       << ( acks_per_window == 0 ? string { "one ACK per segment" }
+                                 : to_string( acks_per_window ) + " ACKs per window" )
+       << " reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
+
+  debug_output << "        TCPSender throughput " << scenario << fixed << setprecision( 2 ) << setw( 5 )
+               << gigabits_per_second << " Gbit/s\n";
+
+  if ( gigabits_per_second < 0.1 ) {
+    throw runtime_error( "TCPSender did not meet minimum speed of 0.1 Gbit/s." );
+  }
+}
+
+void program_body()
+{
+  speed_test( 1e8, 65536, 0, 1370, "(one ACK per segment): " );
+  speed_test( 1e8, 65536, 4, 6163, "(4 ACKs per window):   " );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
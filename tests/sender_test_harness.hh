@@ -55,7 +55,7 @@ public:
   TCPSenderTestHarness( std::string name, TCPConfig config )
     : TestHarness( move( name ),
                    "initial_RTO_ms=" + to_string( config.rt_timeout ) + " and ISN=" + to_string( config.isn ),
-                   { TCPSender { ByteStream { config.send_capacity }, config.isn, config.rt_timeout } } )
+                   { TCPSender { ByteStream { config.send_capacity }, config } } )
   {}
 
   template<std::derived_from<TestStep<TCPSender>> T>
@@ -97,6 +97,41 @@ struct ExpectSeqnosInFlight : public ExpectNumber<TCPSender, uint64_t>
   uint64_t value( const TCPSender& sender ) const override { return sender.sequence_numbers_in_flight(); }
 };
 
+struct ExpectRTO : public ExpectNumber<TCPSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "rtt_estimate().rto_ms"; }
+  uint64_t value( const TCPSender& sender ) const override { return sender.rtt_estimate().rto_ms; }
+};
+
+struct ExpectSRTT : public ExpectNumber<TCPSender, double>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "rtt_estimate().srtt_ms"; }
+  double value( const TCPSender& sender ) const override { return sender.rtt_estimate().srtt_ms; }
+};
+
+struct ExpectCwnd : public ExpectNumber<TCPSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "cwnd"; }
+  uint64_t value( const TCPSender& sender ) const override { return sender.cwnd(); }
+};
+
+struct ExpectSsthresh : public ExpectNumber<TCPSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "ssthresh"; }
+  uint64_t value( const TCPSender& sender ) const override { return sender.ssthresh(); }
+};
+
+struct ExpectPacingDelay : public ExpectNumber<TCPSender, std::optional<uint64_t>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "pacing_delay_ms"; }
+  std::optional<uint64_t> value( const TCPSender& sender ) const override { return sender.pacing_delay_ms(); }
+};
+
 struct ExpectConsecutiveRetransmissions : public ExpectNumber<TCPSender, uint64_t>
 {
   using ExpectNumber::ExpectNumber;
@@ -222,7 +257,11 @@ struct Receive : public Action<SenderAndOutput>
   std::string description() const override
   {
     std::ostringstream desc;
-    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size << ")";
+    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size;
+    for ( const auto& block : msg_.sack ) {
+      desc << ", sack=" << to_string( block.left ) << "-" << to_string( block.right );
+    }
+    desc << ")";
     if ( push_ ) {
       desc << ", then push";
     }
@@ -235,6 +274,12 @@ struct Receive : public Action<SenderAndOutput>
     return *this;
   }
 
+  Receive& with_sack( Wrap32 left, Wrap32 right )
+  {
+    msg_.sack.push_back( { left, right } );
+    return *this;
+  }
+
   void execute( SenderAndOutput& ss ) const override
   {
     ss.sender.receive( msg_ );
@@ -262,6 +307,13 @@ struct Close : public Push
   Close() : Push( "" ) { with_close(); }
 };
 
+struct Flush : public Action<SenderAndOutput>
+{
+  std::string description() const override { return "flush"; }
+  void execute( SenderAndOutput& ss ) const override { ss.sender.flush( ss.make_transmit() ); }
+  constexpr std::string obj() const override { return "TCPSender"; }
+};
+
 class MessageExpectationViolation : public ExpectationViolation
 {
 public:
@@ -0,0 +1,100 @@
+#include "eventloop.hh"
+#include "exception.hh"
+#include "socket.hh"
+#include "splice_pipe.hh"
+
+#include <array>
+#include <exception>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+void expect( const string& description, uint64_t actual, uint64_t expected )
+{
+  if ( actual != expected ) {
+    throw runtime_error( description + ": expected " + to_string( expected ) + " but got " + to_string( actual ) );
+  }
+}
+
+array<LocalStreamSocket, 2> socket_pair()
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "socketpair", ::socketpair( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds.data() ) );
+  return { LocalStreamSocket { FileDescriptor { fds[0] } }, LocalStreamSocket { FileDescriptor { fds[1] } } };
+}
+
+array<FileDescriptor, 2> pipe_pair()
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "pipe2", ::pipe2( fds.data(), O_NONBLOCK ) );
+  return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+}
+
+// Relay everything from `source` to `destination`, the way bidirectional_stream_copy does
+void relay( SplicePipe& pipe, FileDescriptor& source, FileDescriptor& destination )
+{
+  EventLoop eventloop {};
+  eventloop.add_rule(
+    "splice into pipe",
+    source,
+    Direction::In,
+    [&] { pipe.fill_from( source ); },
+    [&] { return pipe.wants_input(); },
+    [&] { pipe.set_source_done(); } );
+  eventloop.add_rule(
+    "splice out of pipe",
+    destination,
+    Direction::Out,
+    [&] {
+      pipe.drain_to( destination );
+      if ( pipe.source_done() and pipe.buffered() == 0 ) {
+        destination.close();
+      }
+    },
+    [&] { return pipe.buffered() > 0 or ( pipe.source_done() and not destination.closed() ); } );
+  while ( eventloop.wait_next_event( 1000 ) == EventLoop::Result::Success ) {}
+}
+
+// A socket that poll() reported readable may have nothing to read after all. That is no reason to stop
+// reading it, and EventLoop must not mistake the attempt for a busy wait.
+void spurious_wakeup()
+{
+  auto [near, far] = socket_pair();
+  auto [output, input] = pipe_pair();
+  SplicePipe pipe { 65536 };
+
+  const unsigned reads_before = near.read_count();
+  pipe.fill_from( near );
+  expect( "bytes buffered from an empty socket", pipe.buffered(), 0 );
+  expect( "pipe still wants input", pipe.wants_input(), true );
+  expect( "socket's read count", near.read_count(), reads_before + 1 );
+
+  far.write( "hello" );
+  far.shutdown( SHUT_WR );
+  relay( pipe, near, input );
+  string received;
+  output.read( received );
+  if ( received != "hello" ) {
+    throw runtime_error( "relayed \"" + received + "\" instead of \"hello\"" );
+  }
+  expect( "source done", pipe.source_done(), true );
+}
+} // namespace
+
+int main()
+{
+  try {
+    spurious_wakeup();
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,225 @@
+#include "spsc_byte_stream.hh"
+
+#include "exception.hh"
+#include "file_descriptor.hh"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+string random_data( size_t len, size_t random_seed )
+{
+  default_random_engine rd { random_seed };
+  uniform_int_distribution<char> ud;
+  string ret;
+  for ( size_t i = 0; i < len; ++i ) {
+    ret += ud( rd );
+  }
+  return ret;
+}
+
+pair<FileDescriptor, FileDescriptor> unix_socket_pair()
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "socketpair", ::socketpair( AF_UNIX, SOCK_STREAM, 0, fds.data() ) );
+  return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+}
+
+double gigabits_per_second( size_t bytes, steady_clock::duration elapsed )
+{
+  return 8 * static_cast<double>( bytes ) / duration_cast<duration<double>>( elapsed ).count() / 1e9;
+}
+
+// Stream `rounds` copies of `data` from a producer thread to this thread through an SPSCByteStream.
+double spsc_throughput( const string& data, size_t rounds, size_t capacity, size_t write_size )
+{
+  SPSCByteStream stream { capacity };
+
+  thread producer { [&] {
+    for ( size_t round = 0; round < rounds; ++round ) {
+      for ( size_t i = 0; i < data.size(); ) {
+        const auto pushed = stream.push( string_view { data }.substr( i, write_size ) );
+        if ( pushed == 0 ) {
+          stream.wait_writable();
+        }
+        i += pushed;
+      }
+    }
+    stream.close();
+  } };
+
+  const auto start_time = steady_clock::now();
+  while ( not stream.is_finished() ) {
+    const auto peeked = stream.peek();
+    if ( peeked.empty() ) {
+      stream.wait_readable();
+      continue;
+    }
+    const size_t offset = stream.bytes_popped() % data.size();
+    const size_t len = min( peeked.size(), data.size() - offset );
+    if ( memcmp( peeked.data(), data.data() + offset, len ) != 0 ) {
+      throw runtime_error( "Mismatch between data written and read" );
+    }
+    stream.pop( len );
+  }
+  const auto stop_time = steady_clock::now();
+  producer.join();
+
+  if ( stream.bytes_popped() != rounds * data.size() ) {
+    throw runtime_error( "SPSCByteStream lost data" );
+  }
+
+  return gigabits_per_second( rounds * data.size(), stop_time - start_time );
+}
+
+// The same transfer through an AF_UNIX socketpair, as TCPMinnowSocket does today.
+double socketpair_throughput( const string& data, size_t rounds, size_t write_size )
+{
+  auto [reader, writer] = unix_socket_pair();
+
+  thread producer { [&, &writer = writer] {
+    for ( size_t round = 0; round < rounds; ++round ) {
+      for ( size_t i = 0; i < data.size(); ) {
+        i += writer.write( string_view { data }.substr( i, write_size ) );
+      }
+    }
+    writer.close();
+  } };
+
+  string buffer( 65536, 0 );
+  size_t total = 0;
+  const auto start_time = steady_clock::now();
+  while ( true ) {
+    const size_t len = reader.read( span<char> { buffer } );
+    if ( len == 0 ) {
+      break;
+    }
+    total += len;
+  }
+  const auto stop_time = steady_clock::now();
+  producer.join();
+
+  if ( total != rounds * data.size() ) {
+    throw runtime_error( "socketpair lost data" );
+  }
+
+  return gigabits_per_second( total, stop_time - start_time );
+}
+
+// Median round-trip time of a one-byte ping-pong between two threads over a pair of SPSCByteStreams.
+double spsc_round_trip_us( size_t iterations )
+{
+  SPSCByteStream ping { 4096 };
+  SPSCByteStream pong { 4096 };
+
+  thread echo { [&] {
+    for ( size_t i = 0; i < iterations; ++i ) {
+      ping.wait_readable();
+      ping.pop( 1 );
+      pong.push( "x" );
+    }
+  } };
+
+  vector<double> samples;
+  samples.reserve( iterations );
+  for ( size_t i = 0; i < iterations; ++i ) {
+    const auto start_time = steady_clock::now();
+    ping.push( "x" );
+    pong.wait_readable();
+    pong.pop( 1 );
+    samples.push_back( duration_cast<duration<double, micro>>( steady_clock::now() - start_time ).count() );
+  }
+  echo.join();
+
+  ranges::nth_element( samples, samples.begin() + samples.size() / 2 );
+  return samples[samples.size() / 2];
+}
+
+double socketpair_round_trip_us( size_t iterations )
+{
+  auto [near, far] = unix_socket_pair();
+
+  thread echo { [&, &far = far] {
+    array<char, 1> byte {};
+    for ( size_t i = 0; i < iterations; ++i ) {
+      far.read( span<char> { byte } );
+      far.write( string_view { byte.data(), 1 } );
+    }
+  } };
+
+  array<char, 1> byte { 'x' };
+  vector<double> samples;
+  samples.reserve( iterations );
+  for ( size_t i = 0; i < iterations; ++i ) {
+    const auto start_time = steady_clock::now();
+    near.write( string_view { byte.data(), 1 } );
+    near.read( span<char> { byte } );
+    samples.push_back( duration_cast<duration<double, micro>>( steady_clock::now() - start_time ).count() );
+  }
+  echo.join();
+
+  ranges::nth_element( samples, samples.begin() + samples.size() / 2 );
+  return samples[samples.size() / 2];
+}
+
+void program_body()
+{
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  const string data = random_data( 1e7, 2718 );
+  constexpr size_t rounds = 10;
+
+  for ( const size_t capacity : { 65536, 1048576 } ) {
+    const double spsc = spsc_throughput( data, rounds, capacity, 1500 );
+    cout << "SPSCByteStream with capacity=" << capacity << ", write_size=1500 reached " << fixed
+         << setprecision( 2 ) << spsc << " Gbit/s across threads.\n";
+    debug_output << "        SPSCByteStream throughput (capacity " << setw( 7 ) << capacity << "): " << fixed
+                 << setprecision( 2 ) << setw( 6 ) << spsc << " Gbit/s\n";
+
+    if ( spsc < 0.1 ) {
+      throw runtime_error( "SPSCByteStream did not meet minimum speed of 0.1 Gbit/s" );
+    }
+  }
+
+  const double unix_socket = socketpair_throughput( data, rounds, 1500 );
+  cout << "AF_UNIX socketpair with write_size=1500 reached " << fixed << setprecision( 2 ) << unix_socket
+       << " Gbit/s across threads.\n";
+  debug_output << "        AF_UNIX socketpair throughput:         " << fixed << setprecision( 2 ) << setw( 6 )
+               << unix_socket << " Gbit/s\n";
+
+  constexpr size_t iterations = 20000;
+  const double spsc_rtt = spsc_round_trip_us( iterations );
+  const double unix_socket_rtt = socketpair_round_trip_us( iterations );
+  cout << "Median one-byte round trip: SPSCByteStream " << fixed << setprecision( 2 ) << spsc_rtt
+       << " us, AF_UNIX socketpair " << unix_socket_rtt << " us.\n";
+  debug_output << "        SPSCByteStream round trip:             " << fixed << setprecision( 2 ) << setw( 6 )
+               << spsc_rtt << " us\n";
+  debug_output << "        AF_UNIX socketpair round trip:         " << fixed << setprecision( 2 ) << setw( 6 )
+               << unix_socket_rtt << " us\n";
+}
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+#include "fd_adapter.hh"
+#include "lossy_fd_adapter.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Goodput of one TCP connection over a lossy path, by how the sender recovers from loss.
+//
+// Two TCPPeers talk over a simulated link with a fixed one-way delay, in simulated time (1 ms per step).
+// Each peer's end of the link is wrapped in a LossyFdAdapter, and the sender's drops segments in both
+// directions (data on the way out, ACKs on the way in) at the given rate. All runs use NewReno and an
+// adaptive RTO, so the difference is how losses are detected and repaired: by the timer alone, by three
+// duplicate ACKs and NewReno partial ACKs, or from the holes SACK blocks show.
+
+namespace {
+
+constexpr uint64_t one_way_delay_ms = 10;
+constexpr uint64_t time_limit_ms = 3'600'000;
+
+enum class Recovery : uint8_t
+{
+  RTO,
+  FastRetransmit,
+  SACK,
+};
+
+// Messages on their way to one end of the link, with the time each arrives
+using Link = deque<pair<uint64_t, TCPMessage>>;
+
+// An FdAdapter that, instead of a file descriptor, reads from one Link and writes to another
+class SimulatedAdapter : public FdAdapterBase
+{
+public:
+  SimulatedAdapter( Link& inbound, Link& outbound, const uint64_t& clock )
+    : inbound_( &inbound ), outbound_( &outbound ), clock_( &clock )
+  {}
+
+  optional<TCPMessage> read()
+  {
+    if ( inbound_->empty() or inbound_->front().first > *clock_ ) {
+      return {};
+    }
+    TCPMessage ret = move( inbound_->front().second );
+    inbound_->pop_front();
+    return ret;
+  }
+
+  vector<TCPMessage> read_burst( size_t max_datagrams )
+  {
+    vector<TCPMessage> ret;
+    while ( ret.size() < max_datagrams ) {
+      auto msg = read();
+      if ( not msg.has_value() ) {
+        break;
+      }
+      ret.push_back( move( *msg ) );
+    }
+    return ret;
+  }
+
+  // TCPPeer lends the messages it sends, so the link keeps a copy
+  void write( const TCPMessage& msg )
+  {
+    outbound_->emplace_back( *clock_ + one_way_delay_ms, TCPMessage { msg } );
+  }
+
+private:
+  Link* inbound_;
+  Link* outbound_;
+  const uint64_t* clock_;
+};
+
+// Transfer `data` from one peer to the other; returns the simulated time it took, in milliseconds
+uint64_t transfer( const string& data, double loss_rate, Recovery recovery )
+{
+  TCPConfig sender_config;
+  sender_config.congestion_control = CongestionControl::Algorithm::NewReno;
+  sender_config.adaptive_rto = true;
+  sender_config.fast_retransmit = recovery == Recovery::FastRetransmit;
+  sender_config.sack = recovery == Recovery::SACK;
+  TCPConfig receiver_config;
+  receiver_config.sack = recovery == Recovery::SACK;
+
+  uint64_t clock = 0;
+  Link to_sender;
+  Link to_receiver;
+  LossyFdAdapter<SimulatedAdapter> sender_link { SimulatedAdapter { to_sender, to_receiver, clock } };
+  LossyFdAdapter<SimulatedAdapter> receiver_link { SimulatedAdapter { to_receiver, to_sender, clock } };
+
+  const auto loss = static_cast<uint16_t>( loss_rate * numeric_limits<uint16_t>::max() );
+  sender_link.config_mut().loss_rate_up = loss;
+  sender_link.config_mut().loss_rate_dn = loss;
+
+  TCPPeer sender { sender_config };
+  TCPPeer receiver { receiver_config };
+  const auto sender_transmit = [&]( const TCPMessage& msg ) { sender_link.write( msg ); };
+  const auto receiver_transmit = [&]( const TCPMessage& msg ) { receiver_link.write( msg ); };
+  receiver.outbound_writer().close();
+
+  size_t written = 0;
+  string received;
+  received.reserve( data.size() );
+  while ( not receiver.inbound_reader().is_finished() ) {
+    if ( clock > time_limit_ms ) {
+      throw runtime_error( "transfer did not finish within the time limit" );
+    }
+
+    for ( auto& msg : sender_link.read_burst( 64 ) ) {
+      sender.receive( move( msg ), sender_transmit );
+    }
+    for ( auto& msg : receiver_link.read_burst( 64 ) ) {
+      receiver.receive( move( msg ), receiver_transmit );
+    }
+
+    Writer& writer = sender.outbound_writer();
+    const size_t len = min( writer.available_capacity(), data.size() - written );
+    writer.push( data.substr( written, len ) );
+    written += len;
+    if ( written == data.size() and not writer.is_closed() ) {
+      writer.close();
+    }
+    sender.push( sender_transmit );
+    receiver.push( receiver_transmit );
+
+    Reader& reader = receiver.inbound_reader();
+    while ( reader.bytes_buffered() ) {
+      received += reader.peek();
+      reader.pop( received.size() - reader.bytes_popped() );
+    }
+
+    ++clock;
+    sender.tick( 1, sender_transmit );
+    receiver.tick( 1, receiver_transmit );
+  }
+
+  if ( received != data ) {
+    throw runtime_error( "Mismatch between data sent and received" );
+  }
+  return clock;
+}
+
+void program_body()
+{
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  constexpr size_t data_len = 2'000'000;
+  constexpr size_t trials = 10;
+  const string data( data_len, 'x' );
+
+  for ( const double loss_rate : { 0.01, 0.02, 0.03, 0.04, 0.05 } ) {
+    array<double, 3> goodput {}; // by Recovery
+    for ( const auto recovery : { Recovery::RTO, Recovery::FastRetransmit, Recovery::SACK } ) {
+      uint64_t total_ms = 0;
+      for ( size_t trial = 0; trial < trials; ++trial ) {
+        total_ms += transfer( data, loss_rate, recovery );
+      }
+      goodput.at( static_cast<size_t>( recovery ) )
+        = 8.0 * data_len * trials / static_cast<double>( total_ms ) / 1e3;
+    }
+
+    cout << "Goodput at " << fixed << setprecision( 0 ) << loss_rate * 100 << "% loss, " << 2 * one_way_delay_ms
+         << " ms RTT: " << setprecision( 2 ) << goodput[0] << " Mbit/s with RTO only, " << goodput[1]
+         << " Mbit/s with fast retransmit, " << goodput[2] << " Mbit/s with SACK.\n";
+
+    debug_output << "        TCP goodput at " << fixed << setprecision( 0 ) << loss_rate * 100
+                 << "% loss: RTO only " << setprecision( 2 ) << setw( 6 ) << goodput[0]
+                 << " Mbit/s, fast retransmit " << setw( 6 ) << goodput[1] << " Mbit/s, SACK " << setw( 6 )
+                 << goodput[2] << " Mbit/s\n";
+  }
+}
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -27,6 +27,26 @@ int main()
       test_should_be( Wrap32( n ) != Wrap32( m ), n != m );
     }
 
+    // Ordering in sequence space, including across the wrap
+    test_should_be( Wrap32( 1 ) < Wrap32( 3 ), true );
+    test_should_be( Wrap32( 3 ) < Wrap32( 1 ), false );
+    test_should_be( Wrap32( 3 ) <= Wrap32( 3 ), true );
+    test_should_be( Wrap32( UINT32_MAX ) < Wrap32( 0 ), true );
+    test_should_be( Wrap32( 0 ) > Wrap32( UINT32_MAX ), true );
+    test_should_be( Wrap32( UINT32_MAX - 5 ) >= Wrap32( 10 ), false );
+
+    for ( size_t i = 0; i < N_REPS; i++ ) {
+      const uint32_t n = rd();
+      const uint16_t diff = rd();
+      const Wrap32 a { n };
+      const Wrap32 b = a + diff;
+      test_should_be( a < b, diff != 0 );
+      test_should_be( a <= b, true );
+      test_should_be( b > a, diff != 0 );
+      test_should_be( b >= a, true );
+      test_should_be( b < a, false );
+    }
+
   } catch ( const exception& e ) {
     cerr << e.what() << "\n";
     return 1;
@@ -0,0 +1,134 @@
+#include "wrapping_integers.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+// The modulo-and-branches unwrap that Wrap32::unwrap replaced, kept as a baseline
+uint64_t reference_unwrap( uint32_t raw_value, uint32_t zero_point, uint64_t checkpoint )
+{
+  constexpr uint64_t span = uint64_t { 1 } << 32;
+  const uint64_t temp = ( uint64_t { raw_value } + span - zero_point ) % span + ( checkpoint / span ) * span;
+  if ( temp == checkpoint ) {
+    return temp;
+  }
+  if ( temp < checkpoint ) {
+    return checkpoint - temp < temp + span - checkpoint ? temp : temp + span;
+  }
+  return temp - checkpoint < checkpoint + span - temp ? temp : ( temp < span ? temp : temp - span );
+}
+
+// Sequence numbers within a window's distance of the checkpoint, as a sender or receiver sees them
+vector<Wrap32> nearby_seqnos( size_t count, Wrap32 zero_point, uint64_t checkpoint, default_random_engine& rd )
+{
+  uniform_int_distribution<int64_t> distance { -( int64_t { 1 } << 20 ), int64_t { 1 } << 20 };
+  vector<Wrap32> ret;
+  ret.reserve( count );
+  for ( size_t i = 0; i < count; ++i ) {
+    ret.push_back( Wrap32::wrap( checkpoint + distance( rd ), zero_point ) );
+  }
+  return ret;
+}
+
+double ns_per_unwrap( size_t count, size_t rounds, steady_clock::duration elapsed )
+{
+  return duration_cast<duration<double, nano>>( elapsed ).count() / static_cast<double>( count * rounds );
+}
+
+void program_body()
+{
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  constexpr size_t count = 4096;
+  constexpr size_t rounds = 2000;
+
+  default_random_engine rd { 2718 };
+  const Wrap32 zero_point { static_cast<uint32_t>( rd() ) };
+  const uint64_t checkpoint = ( uint64_t { 7 } << 32 ) + 123456;
+  const vector<Wrap32> seqnos = nearby_seqnos( count, zero_point, checkpoint, rd );
+
+  // The raw values, for the baseline (Wrap32 keeps them protected)
+  vector<uint32_t> raw_values;
+  raw_values.reserve( count );
+  for ( const auto& seqno : seqnos ) {
+    raw_values.push_back( static_cast<uint32_t>( seqno.unwrap( Wrap32 { 0 }, 0 ) ) );
+  }
+  const auto zero_raw = static_cast<uint32_t>( zero_point.unwrap( Wrap32 { 0 }, 0 ) );
+
+  vector<uint64_t> expected( count );
+  vector<uint64_t> out( count );
+  uint64_t sink = 0;
+
+  // Baseline
+  auto start_time = steady_clock::now();
+  for ( size_t round = 0; round < rounds; ++round ) {
+    for ( size_t i = 0; i < raw_values.size(); ++i ) {
+      expected[i] = reference_unwrap( raw_values[i], zero_raw, checkpoint + round );
+    }
+    sink += expected[round % count];
+  }
+  const double reference_ns = ns_per_unwrap( count, rounds, steady_clock::now() - start_time );
+
+  // One Wrap32::unwrap call per seqno, over an array whose length is only known at run time
+  start_time = steady_clock::now();
+  for ( size_t round = 0; round < rounds; ++round ) {
+    for ( size_t i = 0; i < seqnos.size(); ++i ) {
+      out[i] = seqnos[i].unwrap( zero_point, checkpoint + round );
+    }
+    sink += out[round % count];
+  }
+  const double scalar_ns = ns_per_unwrap( count, rounds, steady_clock::now() - start_time );
+
+  // The batch kernel
+  start_time = steady_clock::now();
+  for ( size_t round = 0; round < rounds; ++round ) {
+    Wrap32::unwrap( seqnos, zero_point, checkpoint + round, out );
+    sink += out[round % count];
+  }
+  const double batch_ns = ns_per_unwrap( count, rounds, steady_clock::now() - start_time );
+
+  // All three must agree (the last round's results are still in `expected` and `out`)
+  for ( size_t i = 0; i < count; ++i ) {
+    if ( out[i] != expected[i] or seqnos[i].unwrap( zero_point, checkpoint + rounds - 1 ) != expected[i] ) {
+      throw runtime_error( "Wrap32::unwrap disagrees with the reference implementation" );
+    }
+  }
+
+  cout << "Wrap32::unwrap of " << count << " seqnos: reference " << fixed << setprecision( 2 ) << reference_ns
+       << " ns, scalar " << scalar_ns << " ns, batch " << batch_ns << " ns per seqno (checksum " << sink % 1000
+       << ").\n";
+
+  debug_output << "        Wrap32::unwrap (reference): " << fixed << setprecision( 2 ) << setw( 6 ) << reference_ns
+               << " ns/seqno\n";
+  debug_output << "        Wrap32::unwrap (scalar):    " << fixed << setprecision( 2 ) << setw( 6 ) << scalar_ns
+               << " ns/seqno\n";
+  debug_output << "        Wrap32::unwrap (batch):     " << fixed << setprecision( 2 ) << setw( 6 ) << batch_ns
+               << " ns/seqno\n";
+
+  if ( batch_ns > 50 ) {
+    throw runtime_error( "Wrap32::unwrap batch kernel did not meet the maximum of 50 ns per seqno." );
+  }
+}
+} // namespace
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
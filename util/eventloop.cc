@@ -77,6 +77,14 @@ void EventLoop::RuleHandle::cancel()
   }
 }
 
+void EventLoop::RuleHandle::set_active( bool active )
+{
+  const shared_ptr<BasicRule> rule_shared_ptr = rule_weak_ptr_.lock();
+  if ( rule_shared_ptr ) {
+    rule_shared_ptr->active = active;
+  }
+}
+
 // NOLINTBEGIN(*-cognitive-complexity)
 // NOLINTBEGIN(*-signed-bitwise)
 EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
@@ -93,7 +101,7 @@ EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
       }
 
       uint8_t iterations = 0;
-      while ( this_rule.interest() ) {
+      while ( this_rule.wants_service() ) {
         if ( iterations++ >= 128 ) {
           throw runtime_error( "EventLoop: busy wait detected: rule \""
                                + _rule_categories.at( this_rule.category_id ).name + "\" is still interested after "
@@ -142,7 +150,7 @@ EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
       continue;
     }
 
-    if ( this_rule.interest() ) {
+    if ( this_rule.wants_service() ) {
       pollfds.push_back( { this_rule.fd.fd_num(),
                            static_cast<int16_t>( this_rule.direction == Direction::In ? POLLIN : POLLOUT ),
                            0 } );
@@ -209,7 +217,8 @@ EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
       const auto count_before = this_rule.service_count();
       this_rule.callback();
 
-      if ( count_before == this_rule.service_count() and ( not this_rule.fd.closed() ) and this_rule.interest() ) {
+      if ( count_before == this_rule.service_count() and ( not this_rule.fd.closed() )
+           and this_rule.wants_service() ) {
         throw runtime_error( "EventLoop: busy wait detected: rule \""
                              + _rule_categories.at( this_rule.category_id ).name
                              + "\" did not read/write fd and is still interested" );
@@ -33,8 +33,12 @@ private:
     InterestT interest;
     CallbackT callback;
     bool cancel_requested {};
+    bool active { true }; //!< An inactive rule is uninterested without asking its interest() callback
 
     BasicRule( size_t s_category_id, InterestT s_interest, CallbackT s_callback );
+
+    //! Does the rule want to be serviced?
+    bool wants_service() const { return active and interest(); }
   };
 
   struct FDRule : public BasicRule
@@ -79,6 +83,11 @@ public:
     {}
 
     void cancel();
+
+    //! \brief Switch the rule on or off without cancelling it
+    //! \details Intended to be driven by state-change notifications (e.g. ByteStream watermarks), so that
+    //! the rule's interest() callback is only consulted while the rule could actually have work to do.
+    void set_active( bool active );
   };
 
   RuleHandle add_rule(
@@ -2,9 +2,16 @@
 
 #include "exception.hh"
 
+#include <algorithm>
+#include <array>
+#include <climits>
 #include <fcntl.h>
 #include <iostream>
+#include <limits>
+#include <poll.h>
+#include <ranges>
 #include <stdexcept>
+#include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <unistd.h>
@@ -149,6 +156,53 @@ void FileDescriptor::read( vector<string>& buffers )
   }
 }
 
+size_t FileDescriptor::read_size_hint() const
+{
+  int readable = 0;
+  if ( ::ioctl( fd_num(), FIONREAD, &readable ) < 0 ) { // NOLINT(*-vararg)
+    return numeric_limits<size_t>::max();
+  }
+  return max( static_cast<size_t>( readable ), size_t { 1 } );
+}
+
+size_t FileDescriptor::read( span<char> buffer )
+{
+  return read( vector<span<char>> { buffer } );
+}
+
+size_t FileDescriptor::read( const vector<span<char>>& buffers )
+{
+  const size_t count = min<size_t>( buffers.size(), IOV_MAX );
+
+  vector<iovec> iovecs;
+  iovecs.reserve( count );
+  size_t total_size = 0;
+  for ( const auto x : buffers | views::take( count ) ) {
+    iovecs.push_back( { x.data(), x.size() } );
+    total_size += x.size();
+  }
+
+  const ssize_t bytes_read = ::readv( fd_num(), iovecs.data(), static_cast<int>( iovecs.size() ) );
+  if ( bytes_read < 0 ) {
+    if ( internal_fd_->non_blocking_ and ( errno == EAGAIN or errno == EINPROGRESS ) ) {
+      return 0;
+    }
+    throw unix_error { "read" };
+  }
+
+  register_read();
+
+  if ( bytes_read == 0 and total_size != 0 ) {
+    internal_fd_->eof_ = true;
+  }
+
+  if ( bytes_read > static_cast<ssize_t>( total_size ) ) {
+    throw runtime_error( "read() read more than requested" );
+  }
+
+  return bytes_read;
+}
+
 size_t FileDescriptor::write( string_view buffer )
 {
   return write( vector<string_view> { buffer } );
@@ -166,10 +220,13 @@ size_t FileDescriptor::write( const vector<Ref<string>>& buffers )
 
 size_t FileDescriptor::write( const vector<string_view>& buffers )
 {
+  // writev() rejects more than IOV_MAX buffers; the excess is left for the caller's next (partial) write
+  const size_t count = min<size_t>( buffers.size(), IOV_MAX );
+
   vector<iovec> iovecs;
-  iovecs.reserve( buffers.size() );
+  iovecs.reserve( count );
   size_t total_size = 0;
-  for ( const auto x : buffers ) {
+  for ( const auto x : buffers | views::take( count ) ) {
     iovecs.push_back( { const_cast<char*>( x.data() ), x.size() } ); // NOLINT(*-const-cast)
     total_size += x.size();
   }
@@ -189,6 +246,37 @@ size_t FileDescriptor::write( const vector<string_view>& buffers )
   return bytes_written;
 }
 
+size_t FileDescriptor::splice_from( FileDescriptor& source, size_t len )
+{
+  const ssize_t bytes_moved
+    = ::splice( source.fd_num(), nullptr, fd_num(), nullptr, len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK );
+  if ( bytes_moved < 0 ) {
+    if ( errno == EAGAIN ) {
+      // splice(2) doesn't say which end would have blocked, so ask poll(2). The attempt counts as servicing
+      // that end: an EventLoop rule woken for it did its part, and poll won't wake it again until it is ready.
+      array<pollfd, 2> ends { { { source.fd_num(), POLLIN, 0 }, { fd_num(), POLLOUT, 0 } } };
+      CheckSystemCall( "poll", ::poll( ends.data(), ends.size(), 0 ) );
+      if ( ends[0].revents == 0 ) {
+        source.register_read();
+      }
+      if ( ends[1].revents == 0 ) {
+        register_write();
+      }
+      return 0;
+    }
+    throw unix_error { "splice" };
+  }
+
+  source.register_read();
+  register_write();
+
+  if ( bytes_moved == 0 and len != 0 ) {
+    source.set_eof();
+  }
+
+  return bytes_moved;
+}
+
 void FileDescriptor::set_blocking( bool blocking )
 {
   int flags = CheckSystemCall( "fcntl", fcntl( fd_num(), F_GETFL ) ); // NOLINT(*-vararg)
@@ -3,6 +3,7 @@
 #include "ref.hh"
 #include <cstddef>
 #include <memory>
+#include <span>
 #include <vector>
 
 // A reference-counted handle to a file descriptor
@@ -65,12 +66,26 @@ public:
   void read( std::string& buffer );
   void read( std::vector<std::string>& buffers );
 
+  // Read into caller-owned memory (e.g. space reserved in a ByteStream)
+  // returns number of bytes read
+  size_t read( std::span<char> buffer );
+  size_t read( const std::vector<std::span<char>>& buffers );
+
+  // How many bytes a read could return right now ([FIONREAD](\ref man2::ioctl)), so that callers can size
+  // their buffers to it; at least 1, so that a read still sees EOF, and unbounded if the descriptor can't tell
+  size_t read_size_hint() const;
+
   // Attempt to write a buffer
   // returns number of bytes written
   size_t write( std::string_view buffer );
   size_t write( const std::vector<std::string_view>& buffers );
   size_t write( const std::vector<Ref<std::string>>& buffers );
 
+  // Move up to `len` bytes from `source` into this descriptor without copying them through userspace,
+  // via [splice(2)](\ref man2::splice); one of the two must be a pipe
+  // returns number of bytes moved (sets `source` to EOF if it had none left, and 0 if either end would block)
+  size_t splice_from( FileDescriptor& source, size_t len );
+
   // Close the underlying file descriptor
   void close() { internal_fd_->close(); }
 
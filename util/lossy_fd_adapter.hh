@@ -49,6 +49,14 @@ public:
     return ret;
   }
 
+  //! \brief Read a burst from the underlying AdapterT instance, potentially dropping each datagram
+  std::vector<TCPMessage> read_burst( size_t max_datagrams )
+  {
+    auto ret = _adapter.read_burst( max_datagrams );
+    std::erase_if( ret, [&]( const TCPMessage& /* unused */ ) { return _should_drop( false ); } );
+    return ret;
+  }
+
   //! \brief Write to the underlying AdapterT instance, potentially dropping the datagram to be written
   //! \param[in] seg is the packet to either write or drop
   void write( const TCPMessage& seg )
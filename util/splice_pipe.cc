@@ -0,0 +1,57 @@
+#include "splice_pipe.hh"
+
+#include "exception.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+array<FileDescriptor, 2> make_pipe()
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "pipe2", ::pipe2( fds.data(), O_NONBLOCK | O_CLOEXEC ) );
+  return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+}
+
+// Returns the size the kernel granted
+size_t resize_pipe( const FileDescriptor& write_end, size_t capacity )
+{
+  ::fcntl( write_end.fd_num(), F_SETPIPE_SZ, static_cast<int>( capacity ) );                   // NOLINT(*-vararg)
+  const int granted = CheckSystemCall( "fcntl", ::fcntl( write_end.fd_num(), F_GETPIPE_SZ ) ); // NOLINT(*-vararg)
+  return static_cast<size_t>( granted );
+}
+} // namespace
+
+SplicePipe::SplicePipe( size_t capacity ) : SplicePipe( make_pipe(), capacity ) {}
+
+SplicePipe::SplicePipe( array<FileDescriptor, 2> ends, size_t capacity )
+  : read_end_( move( ends[0] ) ), write_end_( move( ends[1] ) ), capacity_( resize_pipe( write_end_, capacity ) )
+{}
+
+void SplicePipe::fill_from( FileDescriptor& source )
+{
+  const size_t moved = write_end_.splice_from( source, capacity_ - buffered_ );
+  buffered_ += moved;
+  source_done_ = source.eof();
+
+  // Nothing moved, from a source that isn't finished: either the source had nothing after all (a spurious
+  // wakeup), or the pipe ran out of slots (each holds up to a page, but may be only partly filled). An empty
+  // pipe can't be out of slots, and waiting for drain_to() to make room would wait forever.
+  full_ = moved == 0 and buffered_ > 0 and not source_done_;
+}
+
+void SplicePipe::drain_to( FileDescriptor& destination )
+{
+  if ( buffered_ ) {
+    const size_t moved = destination.splice_from( read_end_, buffered_ );
+    buffered_ -= moved;
+    full_ &= ( moved == 0 );
+  }
+}
+
+bool SplicePipe::wants_input() const
+{
+  return not source_done_ and not full_ and buffered_ < capacity_;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+#include <array>
+#include <cstddef>
+
+//! \brief One direction of a splice relay: bytes go from a source into a kernel pipe, and from there to a
+//! destination, without ever being copied into userspace.
+//! \details splice(2) needs a pipe at one end of each call; the source and destination can be pipes or
+//! sockets. They should be non-blocking, so that fill_from() and drain_to() can serve EventLoop rules.
+class SplicePipe
+{
+public:
+  //! Ask for a pipe of `capacity` bytes. An unprivileged process may be limited by
+  //! /proc/sys/fs/pipe-max-size, so capacity() is whatever size the kernel actually grants.
+  explicit SplicePipe( size_t capacity );
+
+  void fill_from( FileDescriptor& source );     //!< Move what `source` has to read into the pipe
+  void drain_to( FileDescriptor& destination ); //!< Move what the pipe holds into `destination`
+
+  bool wants_input() const;                         //!< Is there room for more from a source not yet done?
+  size_t buffered() const { return buffered_; }     //!< Bytes spliced into the pipe and not yet out of it
+  size_t capacity() const { return capacity_; }     //!< Size of the pipe
+  bool source_done() const { return source_done_; } //!< Has the source reached EOF (or hung up)?
+  void set_source_done() { source_done_ = true; }   //!< Nothing more will enter the pipe
+
+private:
+  explicit SplicePipe( std::array<FileDescriptor, 2> ends, size_t capacity );
+
+  FileDescriptor read_end_;
+  FileDescriptor write_end_;
+  size_t capacity_;
+  size_t buffered_ {};
+  bool full_ {}; //!< the pipe refused more bytes before `buffered_` reached `capacity_`
+  bool source_done_ {};
+};
@@ -0,0 +1,176 @@
+#include "spsc_byte_stream.hh"
+
+#include "exception.hh"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+using namespace std;
+
+namespace {
+FileDescriptor make_eventfd()
+{
+  return FileDescriptor { CheckSystemCall( "eventfd", ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ) };
+}
+
+// How many times a waiter re-checks the stream before going to sleep on the eventfd
+constexpr unsigned spin_iterations = 1024;
+} // namespace
+
+SPSCByteStream::SPSCByteStream( uint64_t capacity )
+  : capacity_( capacity )
+  , buffer_( bit_ceil( max<uint64_t>( capacity, 1 ) ), '\0' )
+  , mask_( buffer_.size() - 1 )
+  , readable_event_( make_eventfd() )
+  , writable_event_( make_eventfd() )
+{}
+
+uint64_t SPSCByteStream::push( string_view data )
+{
+  const uint64_t write = write_.load( memory_order_relaxed );
+
+  // Only go to the consumer's cache line when our cached view says there isn't room.
+  if ( data.size() > capacity_ - ( write - read_cache_ ) ) {
+    read_cache_ = read_.load( memory_order_acquire );
+  }
+
+  const uint64_t len = min<uint64_t>( data.size(), capacity_ - ( write - read_cache_ ) );
+  if ( len == 0 ) {
+    return 0;
+  }
+
+  const uint64_t start = write & mask_;
+  const uint64_t first = min( len, buffer_.size() - start );
+  memcpy( buffer_.data() + start, data.data(), first );
+  memcpy( buffer_.data(), data.data() + first, len - first );
+
+  write_.store( write + len, memory_order_release );
+  notify( reader_waiting_, readable_event_ );
+  return len;
+}
+
+void SPSCByteStream::close()
+{
+  closed_.store( true, memory_order_release );
+  notify( reader_waiting_, readable_event_ );
+}
+
+bool SPSCByteStream::is_closed() const
+{
+  return closed_.load( memory_order_acquire );
+}
+
+uint64_t SPSCByteStream::available_capacity() const
+{
+  return capacity_ - ( write_.load( memory_order_relaxed ) - read_.load( memory_order_acquire ) );
+}
+
+uint64_t SPSCByteStream::bytes_pushed() const
+{
+  return write_.load( memory_order_relaxed );
+}
+
+string_view SPSCByteStream::peek() const
+{
+  const uint64_t read = read_.load( memory_order_relaxed );
+  if ( write_cache_ == read ) {
+    write_cache_ = write_.load( memory_order_acquire );
+  }
+
+  const uint64_t start = read & mask_;
+  return { buffer_.data() + start, min( write_cache_ - read, buffer_.size() - start ) };
+}
+
+void SPSCByteStream::pop( uint64_t len )
+{
+  const uint64_t read = read_.load( memory_order_relaxed );
+  if ( len > write_cache_ - read ) {
+    write_cache_ = write_.load( memory_order_acquire );
+  }
+
+  read_.store( read + min( len, write_cache_ - read ), memory_order_release );
+  notify( writer_waiting_, writable_event_ );
+}
+
+bool SPSCByteStream::is_finished() const
+{
+  // Check closed_ first: once it is seen, every push that preceded close() is visible too.
+  return closed_.load( memory_order_acquire ) and bytes_buffered() == 0;
+}
+
+uint64_t SPSCByteStream::bytes_buffered() const
+{
+  return write_.load( memory_order_acquire ) - read_.load( memory_order_relaxed );
+}
+
+uint64_t SPSCByteStream::bytes_popped() const
+{
+  return read_.load( memory_order_relaxed );
+}
+
+bool SPSCByteStream::wait_readable( int timeout_ms )
+{
+  return wait( reader_waiting_, readable_event_, timeout_ms, [&] { return bytes_buffered() or is_closed(); } );
+}
+
+bool SPSCByteStream::wait_writable( int timeout_ms )
+{
+  return wait( writer_waiting_, writable_event_, timeout_ms, [&] { return available_capacity() > 0; } );
+}
+
+// Called by one side after it publishes a cursor: wake the other side if (and only if) it is asleep.
+void SPSCByteStream::notify( atomic<bool>& waiting, FileDescriptor& event )
+{
+  atomic_thread_fence( memory_order_seq_cst ); // order the cursor store before the `waiting` load
+  if ( waiting.load( memory_order_relaxed ) and waiting.exchange( false ) ) {
+    const uint64_t one = 1;
+    event.write( { reinterpret_cast<const char*>( &one ), sizeof( one ) } ); // NOLINT(*-reinterpret-cast)
+  }
+}
+
+bool SPSCByteStream::wait( atomic<bool>& waiting, FileDescriptor& event, int timeout_ms, auto&& ready )
+{
+  // Wakeups that leave the stream not ready, and interrupted polls, come out of the same timeout
+  const auto deadline = chrono::steady_clock::now() + chrono::milliseconds( max( timeout_ms, 0 ) );
+  const auto remaining_ms = [&] {
+    if ( timeout_ms < 0 ) {
+      return -1;
+    }
+    const auto remaining = chrono::ceil<chrono::milliseconds>( deadline - chrono::steady_clock::now() );
+    return static_cast<int>( max<chrono::milliseconds::rep>( remaining.count(), 0 ) );
+  };
+
+  for ( unsigned i = 0; i < spin_iterations; ++i ) {
+    if ( ready() ) {
+      return true;
+    }
+  }
+
+  while ( true ) {
+    // Announce ourselves, then re-check: the other side either sees the flag or we see its update.
+    waiting.store( true );
+    atomic_thread_fence( memory_order_seq_cst );
+    if ( ready() ) {
+      waiting.store( false );
+      return true;
+    }
+
+    pollfd pfd { event.fd_num(), POLLIN, 0 };
+    const int polled = ::poll( &pfd, 1, remaining_ms() );
+    if ( polled < 0 and errno == EINTR ) {
+      continue;
+    }
+    if ( CheckSystemCall( "poll", polled ) == 0 ) {
+      waiting.store( false );
+      return ready();
+    }
+
+    uint64_t count {};
+    event.read( span<char> { reinterpret_cast<char*>( &count ), sizeof( count ) } ); // NOLINT(*-reinterpret-cast)
+  }
+}
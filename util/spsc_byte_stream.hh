@@ -0,0 +1,81 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+//! \brief A ByteStream for handing bytes from one thread to another without locks or syscalls.
+//! \details Exactly one thread (the producer) may call the writer-side methods and exactly one
+//! other thread (the consumer) the reader-side methods. The bytes live in a power-of-two ring
+//! shared by both threads; the two cumulative cursors are atomics on separate cache lines, and
+//! each side keeps a private cached copy of the other's cursor so that it only touches the
+//! other side's cache line when its cached view runs out.
+//!
+//! A side that finds nothing to do can block in wait_readable()/wait_writable(). These sleep on an
+//! eventfd that the other side signals only when a waiter has announced itself, so the common
+//! (busy) case costs no system calls at all.
+class SPSCByteStream
+{
+public:
+  explicit SPSCByteStream( uint64_t capacity );
+
+  //! \name Producer side
+  //!@{
+  uint64_t push( std::string_view data ); //!< Push as much of `data` as fits; returns the number of bytes pushed
+  void close();                           //!< Signal that nothing more will be written
+  bool is_closed() const;                 //!< Has the stream been closed?
+  uint64_t available_capacity() const;    //!< How many bytes can be pushed right now?
+  uint64_t bytes_pushed() const;          //!< Total number of bytes cumulatively pushed
+
+  //! Block until there is available capacity (or `timeout_ms` elapses); returns false on timeout
+  bool wait_writable( int timeout_ms = -1 );
+  //!@}
+
+  //! \name Consumer side
+  //!@{
+  std::string_view peek() const;   //!< Peek at the next contiguous bytes (up to the ring's wrap point)
+  void pop( uint64_t len );        //!< Remove `len` bytes from the buffer
+  bool is_finished() const;        //!< Is the stream closed and fully popped?
+  uint64_t bytes_buffered() const; //!< Number of bytes pushed and not yet popped
+  uint64_t bytes_popped() const;   //!< Total number of bytes cumulatively popped
+
+  //! Block until there are bytes to read or the stream is closed (or `timeout_ms` elapses); false on timeout
+  bool wait_readable( int timeout_ms = -1 );
+  //!@}
+
+  //! Shared between two threads, so it can be neither copied nor moved
+  SPSCByteStream( const SPSCByteStream& other ) = delete;
+  SPSCByteStream& operator=( const SPSCByteStream& other ) = delete;
+  SPSCByteStream( SPSCByteStream&& other ) = delete;
+  SPSCByteStream& operator=( SPSCByteStream&& other ) = delete;
+  ~SPSCByteStream() = default;
+
+private:
+  static constexpr size_t cache_line_size = 64;
+
+  // Set up by the constructor and read-only afterwards
+  uint64_t capacity_;
+  std::string buffer_;
+  uint64_t mask_;
+  FileDescriptor readable_event_; //!< eventfd signalled for a consumer blocked in wait_readable()
+  FileDescriptor writable_event_; //!< eventfd signalled for a producer blocked in wait_writable()
+
+  // Written by the producer
+  alignas( cache_line_size ) std::atomic<uint64_t> write_ {};
+  uint64_t read_cache_ {}; //!< producer's last view of read_
+
+  // Written by the consumer
+  alignas( cache_line_size ) std::atomic<uint64_t> read_ {};
+  mutable uint64_t write_cache_ {}; //!< consumer's last view of write_
+
+  // Rarely written by either side
+  alignas( cache_line_size ) std::atomic<bool> closed_ {};
+  std::atomic<bool> reader_waiting_ {};
+  std::atomic<bool> writer_waiting_ {};
+
+  static void notify( std::atomic<bool>& waiting, FileDescriptor& event );
+  static bool wait( std::atomic<bool>& waiting, FileDescriptor& event, int timeout_ms, auto&& ready );
+};
@@ -0,0 +1,41 @@
+#include "tcp_coalescer.hh"
+
+#include <utility>
+
+using namespace std;
+
+namespace {
+bool can_merge( const TCPMessage& first, const TCPMessage& second, size_t max_payload )
+{
+  const TCPSenderMessage& a = first.sender;
+  const TCPSenderMessage& b = second.sender;
+  if ( a.payload.empty() or b.payload.empty() or a.payload.size() + b.payload.size() > max_payload ) {
+    return false;
+  }
+  if ( a.SYN or a.FIN or a.RST or b.SYN or b.RST or first.receiver->RST or second.receiver->RST ) {
+    return false;
+  }
+  return b.seqno == a.seqno + a.payload.size() and first.receiver->ackno == second.receiver->ackno;
+}
+} // namespace
+
+void coalesce_segments( vector<TCPMessage>& messages, size_t max_payload )
+{
+  if ( messages.size() < 2 ) {
+    return;
+  }
+
+  size_t out = 0;
+  for ( size_t i = 1; i < messages.size(); ++i ) {
+    if ( can_merge( messages[out], messages[i], max_payload ) ) {
+      TCPSenderMessage& merged = messages[out].sender;
+      TCPSenderMessage& next = messages[i].sender;
+      merged.payload += next.payload;
+      merged.FIN = next.FIN;
+      messages[out].receiver = move( messages[i].receiver );
+    } else if ( ++out != i ) {
+      messages[out] = move( messages[i] );
+    }
+  }
+  messages.resize( out + 1 );
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "tcp_segment.hh"
+
+#include <cstddef>
+#include <vector>
+
+//! \brief Software receive offload: merge runs of in-order data segments into one larger segment.
+//! \details Under a bulk transfer, the segments read in one wakeup are mostly full-sized and consecutive.
+//! Handing each to TCPPeer separately costs a trip through the receiver, the Reassembler and the sender's
+//! ACK processing, and an ACK of its own. coalesce_segments() merges each segment into the one before it when
+//! nothing is lost by doing so, in the spirit of Linux's GRO:
+//!
+//! - both carry payload (a bare ACK is kept as is: duplicate ACKs are a loss signal to the sender),
+//! - the second starts at the sequence number just past the first,
+//! - neither has RST, the first has neither SYN nor FIN, and the second has no SYN,
+//! - both carry the same ackno (or neither has one), and
+//! - the merged payload stays within `max_payload` bytes.
+//!
+//! The merged segment takes the second segment's FIN and window size (the later advertisement). Order is
+//! otherwise preserved. The messages must own their contents (as those read from the network do).
+void coalesce_segments( std::vector<TCPMessage>& messages, size_t max_payload = 65536 );
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "address.hh"
+#include "byte_stream.hh"
+#include "congestion_control.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
@@ -19,6 +21,46 @@ public:
   size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
   size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
   Wrap32 isn { 137 };                      //!< Default initial sequence number
+
+  //! Adapt the retransmission timeout to the measured round-trip time (RFC 6298), starting from rt_timeout.
+  //! When off, the RTO is rt_timeout after every ACK of new data, doubling on each timeout.
+  bool adaptive_rto = false;
+  uint64_t min_rto = 200;   //!< Lower bound on an adaptive RTO, in milliseconds
+  uint64_t max_rto = 60000; //!< Upper bound on an adaptive RTO (including backoff), in milliseconds
+
+  //! Congestion control for the sender. With None, it sends whatever the peer's receive window allows.
+  CongestionControl::Algorithm congestion_control = CongestionControl::Algorithm::None;
+
+  //! Retransmit after three duplicate ACKs instead of waiting for the RTO, and recover from multiple losses
+  //! in a window with NewReno partial ACKs (RFC 6582)
+  bool fast_retransmit = false;
+
+  //! Selective acknowledgments: the receiver reports the out-of-order data it holds (RFC 2018), and the sender
+  //! keeps a scoreboard of it, retransmitting only the holes (RFC 6675). Implies fast_retransmit.
+  //! Both ends must enable it. There is no SACK-permitted option on the SYN (RFC 2018 section 2), so nothing
+  //! finds out whether the peer sends or reads SACK blocks: a sender without it ignores them, and a sender
+  //! with it, facing a receiver without it, falls back to three duplicate ACKs.
+  bool sack = false;
+
+  //! Pace segments out at window / SRTT * gain instead of sending the whole window at once, the window being
+  //! the smaller of the receive and congestion windows. The gain is higher in slow start, so that pacing
+  //! doesn't hold back the window's growth. Segments are sent as they were before the first RTT sample.
+  bool pacing = false;
+  double pacing_ss_gain = 2.0; //!< Pacing gain in slow start (congestion window below ssthresh)
+  double pacing_ca_gain = 1.2; //!< Pacing gain otherwise
+
+  //! Like TCP_NODELAY: send a segment shorter than MAX_PAYLOAD_SIZE as soon as the window allows. When off,
+  //! Nagle's algorithm (RFC 896) holds it back while sent data is unacknowledged, so small writes coalesce.
+  bool nodelay = true;
+
+  //! Like TCP_CORK: hold back segments shorter than MAX_PAYLOAD_SIZE until more data fills them, the stream
+  //! is closed or flushed, or cork_timeout ms have passed (whatever nodelay says)
+  bool cork = false;
+  uint64_t cork_timeout = 200;
+
+  //! How the inbound stream holds its bytes. Chunked lets received payloads be moved, not copied, all the
+  //! way from the segment to the application (the Reassembler then keeps out-of-order data as slices).
+  ByteStream::Storage recv_storage = ByteStream::Storage::Ring;
 };
 
 //! Config for classes derived from FdAdapter
@@ -31,6 +31,10 @@ public:
   //! Listen and accept using the specified configurations; blocks until accept succeeds or fails
   void listen_and_accept( const TCPConfig& c_tcp, const FdAdapterConfig& c_ad );
 
+  //! Send what has been written so far without waiting for more, even a segment that TCPConfig::nodelay
+  //! or TCPConfig::cork would hold back. Takes effect on the TCPPeer thread's next wakeup.
+  void flush() { _flush_requested.store( true ); }
+
   //! When a connected socket is destructed, it will send a RST
   ~TCPMinnowSocket();
 
@@ -87,6 +91,8 @@ private:
 
   std::atomic_bool _abort { false }; //!< Flag used by the owner to force the TCPPeer thread to shut down
 
+  std::atomic_bool _flush_requested { false }; //!< Flag used by the owner to ask for TCPPeer::flush()
+
   bool _inbound_shutdown { false }; //!< Has TCPMinnowSocket shut down the incoming data to the owner?
 
   bool _outbound_shutdown { false }; //!< Has the owner shut down the outbound data to the TCP connection?
@@ -1,7 +1,9 @@
 #include "tcp_minnow_socket.hh"
 
 #include "exception.hh"
+#include "tcp_coalescer.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <exception>
 #include <iostream>
@@ -11,6 +13,7 @@
 #include <utility>
 
 static constexpr size_t TCP_TICK_MS = 10;
+static constexpr size_t TCP_RECEIVE_BURST = 64; // most datagrams read (and coalesced) per wakeup
 
 inline uint64_t timestamp_ms()
 {
@@ -25,7 +28,14 @@ void TCPMinnowSocket<AdaptT>::_tcp_loop( const std::function<bool()>& condition
 {
   auto base_time = timestamp_ms();
   while ( condition() ) {
-    auto ret = _eventloop.wait_next_event( TCP_TICK_MS );
+    // With pacing holding segments back, wake up when the next is due (the tick sends it)
+    int timeout_ms = TCP_TICK_MS;
+    if ( _tcp.has_value() ) {
+      if ( const auto delay = _tcp->sender().pacing_delay_ms(); delay.has_value() ) {
+        timeout_ms = static_cast<int>( std::min<uint64_t>( *delay, TCP_TICK_MS ) );
+      }
+    }
+    auto ret = _eventloop.wait_next_event( timeout_ms );
     if ( ret == EventLoop::Result::Exit or _abort ) {
       break;
     }
@@ -39,6 +49,16 @@ void TCPMinnowSocket<AdaptT>::_tcp_loop( const std::function<bool()>& condition
       _tcp.value().tick( next_time - base_time, [&]( auto x ) { _datagram_adapter.write( x ); } );
       _datagram_adapter.tick( next_time - base_time );
       base_time = next_time;
+
+      // A flush covers the bytes the owner wrote before asking, so first take any still in the pipe
+      if ( _flush_requested.exchange( false ) ) {
+        Writer& outbound = _tcp->outbound_writer();
+        if ( not _outbound_shutdown and outbound.available_capacity() > 0 ) {
+          const uint64_t len = std::min<uint64_t>( outbound.available_capacity(), _thread_data.read_size_hint() );
+          outbound.commit( _thread_data.read( outbound.reserve( len ) ) );
+        }
+        _tcp->flush( [&]( auto x ) { _datagram_adapter.write( x ); } );
+      }
     }
   }
 }
@@ -75,14 +95,18 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
   //    (needs to be read from the inbound_stream and written
   //    to the local stream socket back to the application)
 
-  // rule 1: read from filtered packet stream and dump into TCPConnection
+  // rule 1: read from filtered packet stream and dump into TCPConnection. Everything waiting is read at
+  // once, and runs of in-order data segments are merged first, so each run costs one trip through the
+  // TCPPeer (and one ACK) instead of one per segment.
   _eventloop.add_rule(
     "receive TCP segment from the network",
     _datagram_adapter.fd(),
     Direction::In,
     [&] {
-      if ( auto seg = _datagram_adapter.read() ) {
-        _tcp->receive( std::move( seg.value() ), [&]( auto x ) { _datagram_adapter.write( x ); } );
+      auto segments = _datagram_adapter.read_burst( TCP_RECEIVE_BURST );
+      coalesce_segments( segments );
+      for ( auto& seg : segments ) {
+        _tcp->receive( std::move( seg ), [&]( auto x ) { _datagram_adapter.write( x ); } );
       }
 
       // debugging output:
@@ -95,15 +119,14 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     [&] { return _tcp->active(); } );
 
   // rule 2: read from pipe into outbound buffer
-  _eventloop.add_rule(
+  auto push_rule = _eventloop.add_rule(
     "push bytes to TCPPeer",
     _thread_data,
     Direction::In,
     [&] {
-      std::string data;
-      data.resize( _tcp->outbound_writer().available_capacity() );
-      _thread_data.read( data );
-      _tcp->outbound_writer().push( move( data ) );
+      Writer& outbound = _tcp->outbound_writer();
+      const uint64_t len = std::min<uint64_t>( outbound.available_capacity(), _thread_data.read_size_hint() );
+      outbound.commit( _thread_data.read( outbound.reserve( len ) ) );
 
       if ( _thread_data.eof() ) {
         _tcp->outbound_writer().close();
@@ -132,18 +155,17 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
     } );
 
   // rule 3: read from inbound buffer into pipe
-  _eventloop.add_rule(
+  auto read_rule = _eventloop.add_rule(
     "read bytes from inbound stream",
     _thread_data,
     Direction::Out,
     [&] {
       Reader& inbound = _tcp->inbound_reader();
-      // Write from the inbound_stream into
-      // the pipe, handling the possibility of a partial
+      // Write everything buffered in the inbound_stream into
+      // the pipe with one writev, handling the possibility of a partial
       // write (i.e., only pop what was actually written).
       if ( inbound.bytes_buffered() ) {
-        const std::string_view buffer = inbound.peek();
-        const auto bytes_written = _thread_data.write( buffer );
+        const auto bytes_written = _thread_data.write( inbound.peek_all() );
         inbound.pop( bytes_written );
       }
 
@@ -166,6 +188,15 @@ void TCPMinnowSocket<AdaptT>::_initialize_TCP( const TCPConfig& config )
       std::cerr << "DEBUG: minnow inbound stream had error.\n";
       _tcp->inbound_reader().set_error();
     } );
+
+  // Switch rules 2 and 3 on and off as the streams cross their watermarks, rather than polling
+  // their interest on every iteration. Rule 2 waits for room for a full segment, so that the
+  // application's bytes aren't taken from the pipe one at a time as the window trickles open.
+  _tcp->outbound_writer().set_writable_watermark(
+    std::min( config.send_capacity, TCPConfig::MAX_PAYLOAD_SIZE ),
+    [push_rule]( bool writable ) mutable { push_rule.set_active( writable ); } );
+  _tcp->inbound_reader().set_readable_watermark(
+    1, [read_rule]( bool readable ) mutable { read_rule.set_active( readable ); } );
 }
 
 //! \brief Call [socketpair](\ref man2::socketpair) and return connected Unix-domain sockets of specified type
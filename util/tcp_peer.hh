@@ -28,10 +28,13 @@ public:
 
   /* Passthrough methods */
   void push( const TransmitFunction& transmit ) { sender_.push( make_send( transmit ) ); }
+  void flush( const TransmitFunction& transmit ) { sender_.flush( make_send( transmit ) ); }
   void tick( uint64_t t, const TransmitFunction& transmit )
   {
     cumulative_time_ += t;
     sender_.tick( t, make_send( transmit ) );
+    outbound_writer().tick( t );
+    inbound_reader().tick( t );
   }
   bool has_ackno() const { return receiver_.send().ackno.has_value(); }
 
@@ -65,10 +68,11 @@ public:
     need_send_ |= ( our_ackno.has_value() and msg.sender->seqno + 1 == our_ackno.value() );
 
     // Give incoming TCPSenderMessage to receiver.
+    const bool carries_data = msg.sender->sequence_length() > 0;
     receiver_.receive( std::move( msg.sender ) );
 
     // Give incoming TCPReceiverMessage to sender.
-    sender_.receive( msg.receiver );
+    sender_.receive( msg.receiver, carries_data );
 
     // Send reply if needed.
     push( transmit );
@@ -82,14 +86,19 @@ public:
     }
   }
 
+  // ByteStream occupancy and stall counters for each direction: outbound is the application's data waiting
+  // to be sent, inbound is the data received and waiting for the application to read it.
+  ByteStream::Stats outbound_stats() const { return sender_.reader().stats(); }
+  ByteStream::Stats inbound_stats() const { return receiver_.reader().stats(); }
+
   // Testing interface
   const TCPReceiver& receiver() const { return receiver_; }
   const TCPSender& sender() const { return sender_; }
 
 private:
   TCPConfig cfg_;
-  TCPSender sender_ { ByteStream { cfg_.send_capacity }, cfg_.isn, cfg_.rt_timeout };
-  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity } } };
+  TCPSender sender_ { ByteStream { cfg_.send_capacity }, cfg_ };
+  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity, cfg_.recv_storage } }, cfg_.sack };
 
   bool need_send_ {};
 
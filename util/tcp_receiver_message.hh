@@ -2,7 +2,9 @@
 
 #include "wrapping_integers.hh"
 
+#include <cstddef>
 #include <optional>
+#include <vector>
 
 /*
  * The TCPReceiverMessage structure contains the information sent from a TCP receiver to its sender.
@@ -17,11 +19,25 @@
  *    the <cstdint> header).
  *
  * 3) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
+ *
+ * 4) Selective acknowledgments (RFC 2018): blocks of sequence numbers beyond the ackno that the receiver
+ *    already holds. The first block holds the most recently received segment, and the rest repeat the most
+ *    recently reported blocks (RFC 2018 section 4). Empty unless the receiver sends SACK.
  */
 
 struct TCPReceiverMessage
 {
+  struct SackBlock
+  {
+    Wrap32 left;  // first sequence number held
+    Wrap32 right; // sequence number just past the block
+  };
+
+  // Most blocks that fit in the TCP header's 40 bytes of options (RFC 2018 section 3)
+  static constexpr size_t MAX_SACK_BLOCKS = 4;
+
   std::optional<Wrap32> ackno {};
   uint16_t window_size {};
   bool RST {};
+  std::vector<SackBlock> sack {};
 };
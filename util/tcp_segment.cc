@@ -3,12 +3,73 @@
 #include "helpers.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
 
 static_assert( !( TCPSegment::HEADER_LENGTH & 0x03 ) ); // header length must be divisible by 4
 
+namespace {
+// TCP option kinds (RFC 9293 section 3.2, RFC 2018)
+constexpr uint8_t OPTION_END = 0;
+constexpr uint8_t OPTION_NOP = 1;
+constexpr uint8_t OPTION_SACK = 5;
+
+// A SACK option is two NOPs (for alignment), kind, length, then two 32-bit edges per block
+constexpr uint8_t SACK_OPTION_BASE = 4;
+constexpr uint8_t SACK_BLOCK_LENGTH = 8;
+
+static_assert( TCPSegment::HEADER_LENGTH + SACK_OPTION_BASE
+                 + TCPReceiverMessage::MAX_SACK_BLOCKS * SACK_BLOCK_LENGTH
+               <= 60 ); // largest header the data offset can describe
+
+// Read the options in a header of `options_length` bytes beyond the fixed part. Options other than SACK are
+// skipped; a malformed one ends parsing.
+void parse_options( Parser& parser, size_t options_length, TCPReceiverMessage& receiver )
+{
+  while ( options_length > 0 and not parser.has_error() ) {
+    uint8_t kind {};
+    parser.integer( kind );
+    --options_length;
+    if ( kind == OPTION_END ) {
+      break;
+    }
+    if ( kind == OPTION_NOP ) {
+      continue;
+    }
+
+    uint8_t length {};
+    if ( options_length == 0 ) {
+      parser.set_error();
+      return;
+    }
+    parser.integer( length );
+    --options_length;
+    if ( length < 2 or length - 2U > options_length ) {
+      parser.set_error();
+      return;
+    }
+    const size_t body_length = length - 2U;
+    options_length -= body_length;
+
+    if ( kind == OPTION_SACK and body_length % SACK_BLOCK_LENGTH == 0 ) {
+      receiver.sack.clear();
+      for ( size_t i = 0; i < body_length / SACK_BLOCK_LENGTH; ++i ) {
+        uint32_t left {};
+        uint32_t right {};
+        parser.integer( left );
+        parser.integer( right );
+        receiver.sack.push_back( { Wrap32 { left }, Wrap32 { right } } );
+      }
+    } else {
+      parser.remove_prefix( body_length );
+    }
+  }
+  parser.remove_prefix( options_length ); // padding after the end of the option list
+}
+} // namespace
+
 void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum )
 {
   /* verify checksum */
@@ -48,12 +109,14 @@ void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum
   parser.integer( udinfo.cksum );
   parser.integer( raw16 ); // urgent pointer
 
-  // skip any options or anything extra in the header
   if ( data_offset < ( HEADER_LENGTH >> 2 ) ) {
     parser.set_error();
     return;
   }
-  parser.remove_prefix( data_offset * 4 - HEADER_LENGTH );
+  parse_options( parser, data_offset * 4 - HEADER_LENGTH, message.receiver.get_mut() );
+  if ( parser.has_error() ) {
+    return;
+  }
 
   parser.concatenate_all_remaining( message.sender->payload );
 }
@@ -64,13 +127,23 @@ public:
   uint32_t raw_value() const { return raw_value_; }
 };
 
+uint8_t TCPSegment::header_length() const
+{
+  const auto& sack = message.receiver->sack;
+  if ( sack.empty() ) {
+    return HEADER_LENGTH;
+  }
+  const size_t blocks = min( sack.size(), TCPReceiverMessage::MAX_SACK_BLOCKS );
+  return HEADER_LENGTH + SACK_OPTION_BASE + blocks * SACK_BLOCK_LENGTH;
+}
+
 void TCPSegment::serialize( Serializer& serializer ) const
 {
   serializer.integer( udinfo.src_port );
   serializer.integer( udinfo.dst_port );
   serializer.integer( Wrap32Serializable { message.sender->seqno }.raw_value() );
   serializer.integer( Wrap32Serializable { message.receiver->ackno.value_or( Wrap32 { 0 } ) }.raw_value() );
-  serializer.integer( uint8_t { ( HEADER_LENGTH >> 2 ) << 4 } ); // data offset
+  serializer.integer( static_cast<uint8_t>( ( header_length() >> 2 ) << 4 ) ); // data offset
   const bool reset = message.sender->RST or message.receiver->RST;
   const uint8_t flags = ( message.receiver->ackno.has_value() ? 0b0001'0000U : 0 ) | ( reset ? 0b0000'0100U : 0 )
                         | ( message.sender->SYN ? 0b0000'0010U : 0 ) | ( message.sender->FIN ? 0b0000'0001U : 0 );
@@ -78,6 +151,20 @@ void TCPSegment::serialize( Serializer& serializer ) const
   serializer.integer( message.receiver->window_size );
   serializer.integer( udinfo.cksum );
   serializer.integer( uint16_t { 0 } ); // urgent pointer
+
+  const auto& sack = message.receiver->sack;
+  if ( not sack.empty() ) {
+    const size_t blocks = min( sack.size(), TCPReceiverMessage::MAX_SACK_BLOCKS );
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_SACK );
+    serializer.integer( static_cast<uint8_t>( 2 + blocks * SACK_BLOCK_LENGTH ) );
+    for ( size_t i = 0; i < blocks; ++i ) {
+      serializer.integer( Wrap32Serializable { sack[i].left }.raw_value() );
+      serializer.integer( Wrap32Serializable { sack[i].right }.raw_value() );
+    }
+  }
+
   serializer.buffer( message.sender->payload );
 }
 
@@ -113,6 +200,10 @@ string TCPSegment::to_string() const
   if ( ackno.has_value() ) {
     ss << " ACK<" << Wrap32Serializable { *ackno }.raw_value() << ">";
   }
+  for ( const auto& block : message.receiver->sack ) {
+    ss << " SACK<" << Wrap32Serializable { block.left }.raw_value() << ","
+       << Wrap32Serializable { block.right }.raw_value() << ">";
+  }
   ss << " winsize=" << message.receiver->window_size;
   ss << " src=" << udinfo.src_port << " dst=" << udinfo.dst_port;
   return ss.str();
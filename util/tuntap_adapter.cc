@@ -1,9 +1,19 @@
 #include "tuntap_adapter.hh"
+#include "exception.hh"
 #include "helpers.hh"
 
+#include <poll.h>
+
 using namespace std;
 
-optional<TCPMessage> TCPOverIPv4OverTunFdAdapter::read()
+bool TCPOverIPv4OverTunFdAdapter::_datagram_waiting() const
+{
+  pollfd pfd { _tun.fd_num(), POLLIN, 0 };
+  CheckSystemCall( "poll", ::poll( &pfd, 1, 0 ) );
+  return static_cast<bool>( pfd.revents & POLLIN );
+}
+
+void TCPOverIPv4OverTunFdAdapter::_read_datagram( optional<TCPMessage>& message )
 {
   vector<string> strs( 3 );
   strs[0].resize( IPv4Header::LENGTH );
@@ -12,9 +22,29 @@ optional<TCPMessage> TCPOverIPv4OverTunFdAdapter::read()
 
   InternetDatagram ip_dgram;
   if ( parse( ip_dgram, move( strs ) ) ) {
-    return unwrap_tcp_in_ip( move( ip_dgram ) );
+    message = unwrap_tcp_in_ip( move( ip_dgram ) );
+  }
+}
+
+optional<TCPMessage> TCPOverIPv4OverTunFdAdapter::read()
+{
+  optional<TCPMessage> message;
+  _read_datagram( message );
+  return message;
+}
+
+vector<TCPMessage> TCPOverIPv4OverTunFdAdapter::read_burst( size_t max_datagrams )
+{
+  vector<TCPMessage> messages;
+  optional<TCPMessage> message;
+  for ( size_t i = 0; i < max_datagrams and _datagram_waiting(); ++i ) {
+    _read_datagram( message );
+    if ( message.has_value() ) {
+      messages.push_back( std::move( message.value() ) );
+      message.reset();
+    }
   }
-  return {};
+  return messages;
 }
 
 void TCPOverIPv4OverTunFdAdapter::write( const TCPMessage& seg )
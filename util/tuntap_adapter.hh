@@ -7,12 +7,15 @@
 
 #include <optional>
 #include <utility>
+#include <vector>
 
 template<class T>
-concept TCPDatagramAdapter = requires( T a, TCPMessage seg ) {
+concept TCPDatagramAdapter = requires( T a, TCPMessage seg, size_t max_datagrams ) {
   { a.write( seg ) } -> std::same_as<void>;
 
   { a.read() } -> std::same_as<std::optional<TCPMessage>>;
+
+  { a.read_burst( max_datagrams ) } -> std::same_as<std::vector<TCPMessage>>;
 };
 
 //! \brief A FD adapter for IPv4 datagrams read from and written to a TUN device
@@ -21,6 +24,12 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter
 private:
   TunFD _tun;
 
+  //! Is a datagram waiting to be read? (The TunFD stays blocking, so that writes never fail for lack of room.)
+  bool _datagram_waiting() const;
+
+  //! Reads one datagram into `message` (left empty if it is not for us)
+  void _read_datagram( std::optional<TCPMessage>& message );
+
 public:
   //! Construct from a TunFD
   explicit TCPOverIPv4OverTunFdAdapter( TunFD&& tun ) : _tun( std::move( tun ) ) {}
@@ -28,6 +37,10 @@ public:
   //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection
   std::optional<TCPMessage> read();
 
+  //! Reads up to `max_datagrams` datagrams, stopping early once none are waiting, and returns the
+  //! TCP segments among them that are related to the current connection, in arrival order
+  std::vector<TCPMessage> read_burst( size_t max_datagrams );
+
   //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
   void write( const TCPMessage& seg );
 